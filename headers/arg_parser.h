@@ -35,6 +35,11 @@ struct ArgBundle : public Printable {
 
 /* Global Data */
 extern std::unordered_set<std::string> const RADIUS_TYPES;
+extern std::unordered_set<std::string> const RMSD_ENGINES;
+extern std::unordered_set<std::string> const MIGRATION_TOPOLOGIES;
+extern std::unordered_set<std::string> const GA_MODES;
+extern std::unordered_set<std::string> const MUTATION_SCHEDULES;
+extern std::unordered_set<std::string> const NUMA_POLICIES;
 
 class ArgParser {
 private:
@@ -84,6 +89,20 @@ private:
             true,
             &ArgParser::set_output_suffix
         },
+        {   "sd",
+            "seed_solutions",
+            "Set file of prior solutions to start from, e.g. an earlier output.",
+            true,
+            &ArgParser::set_seed_solutions
+        },
+        {   "sdr",
+            "seed_rate",
+            string_format("Set share of the initial population built from "
+            "seed solutions and their mutants (default=%.2f).",
+            options_.seed_rate),
+            true,
+            &ArgParser::set_seed_rate
+        },
         {   "l",
             "len_dev",
             string_format("Set length deviation allowance (default=%zu).",
@@ -113,7 +132,7 @@ private:
             string_format("Set radius type (default=%s).\n"
             "    Valid values are: %s.",
             options_.radius_type.c_str(),
-            radius_types_setting_string().c_str()),
+            setting_string(RADIUS_TYPES).c_str()),
             true,
             &ArgParser::set_radius_type
         },
@@ -125,6 +144,15 @@ private:
             true,
             &ArgParser::set_radius_factor
         },
+        {   "re",
+            "rmsd_engine",
+            string_format("Set RMSD engine (default=%s).\n"
+            "    Valid values are: %s.",
+            options_.rmsd_engine.c_str(),
+            setting_string(RMSD_ENGINES).c_str()),
+            true,
+            &ArgParser::set_rmsd_engine
+        },
         {   "S",
             "seed",
             string_format("Set RNG seed (default=0x%x). "
@@ -133,6 +161,24 @@ private:
             true,
             &ArgParser::set_seed
         },
+        {   "gm",
+            "ga_mode",
+            string_format("Set GA mode (default=%s).\n"
+            "    Valid values are: %s.",
+            options_.ga_mode.c_str(),
+            setting_string(GA_MODES).c_str()),
+            true,
+            &ArgParser::set_ga_mode
+        },
+        {   "gmu",
+            "ga_mutation_schedule",
+            string_format("Set how mutation modes are picked (default=%s).\n"
+            "    Valid values are: %s.",
+            options_.ga_mutation_schedule.c_str(),
+            setting_string(MUTATION_SCHEDULES).c_str()),
+            true,
+            &ArgParser::set_ga_mutation_schedule
+        },
         {   "p",
             "ga_pop_size",
             string_format("Set GA population size (default=%zu).",
@@ -178,6 +224,57 @@ private:
                 options_.ga_max_restarts),
             true, &ArgParser::set_ga_max_restarts
         },
+        {   "gi",
+            "ga_islands",
+            string_format("Set number of GA islands (default=%zu). "
+            "\n    The population is split evenly among islands.",
+            options_.ga_islands),
+            true,
+            &ArgParser::set_ga_islands
+        },
+        {   "gmi",
+            "ga_migration_interval",
+            string_format("Set number of generations between "
+            "island migrations (default=%zu)."
+            "\n    Values <= 0 means no migration.",
+            options_.ga_migration_interval),
+            true,
+            &ArgParser::set_ga_migration_interval
+        },
+        {   "gms",
+            "ga_migration_size",
+            string_format("Set number of best teams each island sends "
+            "per migration (default=%zu).",
+            options_.ga_migration_size),
+            true,
+            &ArgParser::set_ga_migration_size
+        },
+        {   "gmt",
+            "ga_migration_topology",
+            string_format("Set which islands receive migrants (default=%s).\n"
+            "    Valid values are: %s.",
+            options_.ga_migration_topology.c_str(),
+            setting_string(MIGRATION_TOPOLOGIES).c_str()),
+            true,
+            &ArgParser::set_ga_migration_topology
+        },
+        {   "lse",
+            "ga_local_search_elites",
+            string_format("Set number of best survivors refined by local "
+            "search each generation (default=%zu)."
+            "\n    Values <= 0 means no local search.",
+            options_.ga_local_search_elites),
+            true,
+            &ArgParser::set_ga_local_search_elites
+        },
+        {   "lsb",
+            "ga_local_search_budget",
+            string_format("Set number of neighbors each refined survivor "
+            "tries per generation (default=%zu).",
+            options_.ga_local_search_budget),
+            true,
+            &ArgParser::set_ga_local_search_budget
+        },
         {   "v",
             "verbosity",
             string_format("Set log verbosity (default=%d). "
@@ -203,6 +300,22 @@ private:
             true,
             &ArgParser::set_n_workers
         },
+        {   "pin",
+            "pin_threads",
+            "Pin worker threads to NUMA nodes, in blocks of consecutive threads.",
+            false,
+            &ArgParser::set_pin_threads
+        },
+        {   "numa",
+            "numa_policy",
+            string_format("Set how the population is placed on NUMA nodes "
+            "(default=%s).\n    Valid values are: %s.\n    Under local, "
+            "results depend on the number of NUMA nodes.",
+            options_.numa_policy.c_str(),
+            setting_string(NUMA_POLICIES).c_str()),
+            true,
+            &ArgParser::set_numa_policy
+        },
         {   "k",
             "keep_n",
             string_format("Set number of best solutions to "
@@ -211,6 +324,28 @@ private:
             true,
             &ArgParser::set_keep_n
         },
+        {   "fcs",
+            "fitness_cache_size",
+            string_format("Set number of team scores to cache per work "
+            "area (default=%zu).\n    Value 0 disables the cache.",
+            options_.fitness_cache_size),
+            true,
+            &ArgParser::set_fitness_cache_size
+        },
+        {   "ckpt",
+            "checkpoint_interval",
+            string_format("Set number of generations between checkpoints "
+            "(default=%zu).\n    Value 0 disables checkpoints.",
+            options_.checkpoint_interval),
+            true,
+            &ArgParser::set_checkpoint_interval
+        },
+        {   "res",
+            "resume",
+            "Resume work areas from their checkpoints in the output directory.",
+            false,
+            &ArgParser::set_resume
+        },
         {   "dry",
             "dry_run",
             "Dry run mode - exit after initializing first population.",
@@ -228,7 +363,8 @@ private:
     /* accessors */
     ArgBundle const* match_arg_bundle(char const* arg_in) const;
     void check_options() const;
-    std::string radius_types_setting_string() const;
+    std::string setting_string(
+        std::unordered_set<std::string> const& values) const;
 
     /* modifiers */
     void parse_options(int const argc, char const* const argv[]);
@@ -242,24 +378,40 @@ private:
     ARG_CALLBACK_DECL(parse_config);
     ARG_CALLBACK_DECL(set_output_dir);
     ARG_CALLBACK_DECL(set_output_suffix);
+    ARG_CALLBACK_DECL(set_seed_solutions);
+    ARG_CALLBACK_DECL(set_seed_rate);
     ARG_CALLBACK_DECL(set_len_dev);
     ARG_CALLBACK_DECL(set_avg_pair_dist);
     ARG_CALLBACK_DECL(set_seed);
+    ARG_CALLBACK_DECL(set_ga_mode);
+    ARG_CALLBACK_DECL(set_ga_mutation_schedule);
     ARG_CALLBACK_DECL(set_ga_pop_size);
     ARG_CALLBACK_DECL(set_ga_max_iters);
     ARG_CALLBACK_DECL(set_ga_survive_rate);
     ARG_CALLBACK_DECL(set_ga_stop_score);
     ARG_CALLBACK_DECL(set_ga_restart_trigger);
     ARG_CALLBACK_DECL(set_ga_max_restarts);
+    ARG_CALLBACK_DECL(set_ga_islands);
+    ARG_CALLBACK_DECL(set_ga_migration_interval);
+    ARG_CALLBACK_DECL(set_ga_migration_size);
+    ARG_CALLBACK_DECL(set_ga_migration_topology);
+    ARG_CALLBACK_DECL(set_ga_local_search_elites);
+    ARG_CALLBACK_DECL(set_ga_local_search_budget);
     ARG_CALLBACK_DECL(set_verbosity);
     ARG_CALLBACK_DECL(set_run_tests);
     ARG_CALLBACK_DECL(set_device);
     ARG_CALLBACK_DECL(set_n_workers);
+    ARG_CALLBACK_DECL(set_pin_threads);
+    ARG_CALLBACK_DECL(set_numa_policy);
     ARG_CALLBACK_DECL(set_keep_n);
+    ARG_CALLBACK_DECL(set_fitness_cache_size);
+    ARG_CALLBACK_DECL(set_checkpoint_interval);
+    ARG_CALLBACK_DECL(set_resume);
     ARG_CALLBACK_DECL(set_dry_run);
     ARG_CALLBACK_DECL(set_radius_type);
     ARG_CALLBACK_DECL(set_radius_factor);
     ARG_CALLBACK_DECL(set_collision_penalty);
+    ARG_CALLBACK_DECL(set_rmsd_engine);
 
     /* printers */
     ARG_CALLBACK_DECL(help_and_exit);
@@ -0,0 +1,116 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace elfin {
+
+/* Fwd Decl */
+struct TestStat;
+class WorkArea;
+
+namespace checkpoint {
+
+// Bumped whenever the layout of a checkpoint changes.
+uint32_t const VERSION = 5;
+
+// Streams values into a temporary file next to path through a fixed buffer,
+// so that nothing is staged in memory. The file only replaces path on
+// commit(), so an interrupted write leaves the last checkpoint intact.
+class Writer {
+protected:
+    /* data */
+    std::string const path_;
+    std::string const tmp_path_;
+    FILE* file_ = nullptr;
+
+    /* modifiers */
+    void write(void const* const data, size_t const size);
+
+public:
+    /* ctors */
+    Writer(std::string const& path);
+
+    /* dtors */
+    // Removes the temporary file unless committed.
+    virtual ~Writer();
+
+    /* modifiers */
+    template <typename T>
+    void put(T const& value) {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only plain values can be written as they are");
+        write(&value, sizeof(T));
+    }
+    void put_string(std::string const& str);
+    template <typename T>
+    void put_vector(std::vector<T> const& vec) {
+        put<uint64_t>(vec.size());
+        for (auto const& value : vec) {
+            put(value);
+        }
+    }
+    // Flushes to disk and renames the file over path, then flushes the
+    // directory so that the rename survives a crash.
+    void commit();
+};
+
+// Reads what Writer wrote, in the same order. Throws CouldNotParse if the
+// file ends early, or if a length read from it is longer than what is left.
+class Reader {
+protected:
+    /* data */
+    std::string const path_;
+    FILE* file_ = nullptr;
+    size_t size_ = 0;
+
+    /* modifiers */
+    void read(void* const data, size_t const size);
+
+public:
+    /* ctors */
+    Reader(std::string const& path);
+
+    /* dtors */
+    virtual ~Reader();
+
+    /* modifiers */
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only plain values can be read as they are");
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+    // Reads the length of anything whose elements take at least elem_size
+    // bytes each, so that a corrupt length fails before it is allocated.
+    uint64_t get_length(size_t const elem_size);
+    std::string get_string();
+    template <typename T>
+    std::vector<T> get_vector() {
+        std::vector<T> res(get_length(sizeof(T)));
+        for (auto& value : res) {
+            value = get<T>();
+        }
+        return res;
+    }
+};
+
+/* free functions */
+// Where the checkpoint of work_area goes, under the output directory.
+std::string path_of(WorkArea const& work_area);
+bool exists(WorkArea const& work_area);
+
+/* tests */
+TestStat test();
+
+}  /* checkpoint */
+
+}  /* elfin */
+
+#endif  /* end of include guard: CHECKPOINT_H_ */
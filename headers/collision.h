@@ -0,0 +1,97 @@
+#ifndef COLLISION_H_
+#define COLLISION_H_
+
+#include <vector>
+#include <cstdint>
+
+#include "geometry.h"
+
+namespace elfin {
+
+struct TestStat;
+
+namespace collision {
+
+// Spheres in structure-of-arrays layout, e.g. the modules of a design.
+class Spheres {
+protected:
+    /* data */
+    std::vector<float> xs_, ys_, zs_;
+    std::vector<float> sq_radii_;
+    float max_radius_ = 0;
+
+public:
+    /* accessors */
+    size_t size() const { return xs_.size(); }
+    float const* xs() const { return xs_.data(); }
+    float const* ys() const { return ys_.data(); }
+    float const* zs() const { return zs_.data(); }
+    float const* sq_radii() const { return sq_radii_.data(); }
+    float max_radius() const { return max_radius_; }
+
+    /* modifiers */
+    // Keeps capacity so that a thread_local instance can be refilled without
+    // allocating.
+    void clear();
+    void push_back(Vector3f const& center, float const radius);
+};
+
+// True if any two spheres i != j have centers closer than max(r_i, r_j),
+// i.e. one center lies inside the other sphere. Each pair is checked at most
+// once, and the search stops at the first hit.
+//
+// Larger sets go through a spatial hash with cells as wide as the largest
+// radius, so only spheres in neighbouring cells are compared.
+bool any_overlap(Spheres const& spheres);
+
+// Static bounding volume hierarchy over spheres that never move, e.g. the
+// modules placed by the user in a spec. Queries use the same overlap test as
+// any_overlap().
+class SphereTree {
+protected:
+    /* types */
+    // Bounds the centers of spheres [begin, end) and their largest radius.
+    // Leaves have no children; otherwise the left child follows its parent
+    // and the right child is at index right.
+    struct Node {
+        float lo[3], hi[3];
+        float max_radius;
+        uint32_t begin, end;
+        uint32_t right = 0;
+    };
+
+    /* data */
+    Spheres spheres_;  // Reordered so that every node covers a range.
+    std::vector<Node> nodes_;
+
+    /* accessors */
+    bool overlaps(float const x,
+                  float const y,
+                  float const z,
+                  float const sq_radius) const;
+
+    /* modifiers */
+    void build(std::vector<uint32_t>& ids,
+               uint32_t const begin,
+               uint32_t const end,
+               Spheres const& spheres);
+
+public:
+    /* ctors */
+    SphereTree() {}
+    SphereTree(Spheres const& spheres);
+
+    /* accessors */
+    size_t size() const { return spheres_.size(); }
+    bool overlaps(Vector3f const& center, float const radius) const;
+    bool overlaps_any(Spheres const& spheres) const;
+};
+
+/* tests */
+TestStat test();
+
+}  /* collision */
+
+}  /* elfin */
+
+#endif  /* end of include guard: COLLISION_H_ */
@@ -29,7 +29,7 @@ protected:
                                           Transform const& shift_tx);
 public:
     /* ctors */
-    DoubleHingeTeam(WorkArea const* const wa, uint32_t const seed);
+    DoubleHingeTeam(WorkArea const* const wa, random::Stream const& seed);
     DoubleHingeTeam(DoubleHingeTeam const& other);
     DoubleHingeTeam(DoubleHingeTeam&& other);
 
@@ -39,6 +39,8 @@ public:
     /* modifiers */
     DoubleHingeTeam& operator=(DoubleHingeTeam const& other);
     DoubleHingeTeam& operator=(DoubleHingeTeam && other);
+    virtual bool prepare_score();
+    virtual void read_checkpoint(checkpoint::Reader& reader);
 
     /* tests */
     static TestStat test();
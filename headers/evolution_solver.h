@@ -24,6 +24,10 @@ public:
 	/* dtors */
 	virtual ~EvolutionSolver();
 
+	/* accessors */
+	// Mutation tallies of all generations of the last run().
+	mutation::Stats const& mutation_stats() const;
+
 	/* modifiers */
 	void run(WorkArea const& work_area, TeamSPMaxHeap& output);
 
@@ -0,0 +1,85 @@
+#ifndef FIRST_RANK_TABLE_H_
+#define FIRST_RANK_TABLE_H_
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "checksum.h"
+#include "debug_utils.h"
+
+namespace elfin {
+
+/* Fwd Decl */
+struct TestStat;
+
+// Open addressing map from checksum to the lowest rank holding it, filled
+// concurrently. Each slot packs the checksum above the rank so that both are
+// updated by one compare-and-swap.
+class FirstRankTable {
+private:
+    /* data */
+    static uint64_t const EMPTY = UINT64_MAX;
+    size_t mask_ = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+
+    /* accessors */
+    static Crc32 crc_of(uint64_t const slot) { return slot >> 32; }
+    static size_t rank_of(uint64_t const slot) { return slot & 0xffffffff; }
+    size_t home(Crc32 const crc) const { return crc & mask_; }
+
+public:
+    /* ctors */
+    FirstRankTable(size_t const n_ranks) {
+        // At most half full.
+        size_t n_slots = 1;
+        while (n_slots < 2 * n_ranks) {
+            n_slots <<= 1;
+        }
+        mask_ = n_slots - 1;
+
+        slots_.reset(new std::atomic<uint64_t>[n_slots]);
+        for (size_t i = 0; i < n_slots; ++i) {
+            slots_[i].store(EMPTY, std::memory_order_relaxed);
+        }
+    }
+
+    /* accessors */
+    // Only valid for checksums that were inserted.
+    size_t first_rank(Crc32 const crc) const {
+        for (size_t i = home(crc); ; i = (i + 1) & mask_) {
+            uint64_t const slot = slots_[i].load(std::memory_order_relaxed);
+            DEBUG_NOMSG(slot == EMPTY);
+            if (crc_of(slot) == crc) {
+                return rank_of(slot);
+            }
+        }
+    }
+
+    /* modifiers */
+    void insert(Crc32 const crc, size_t const rank) {
+        uint64_t const entry = (uint64_t(crc) << 32) | rank;
+        for (size_t i = home(crc); ; i = (i + 1) & mask_) {
+            uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+            while (slot == EMPTY or
+                    (crc_of(slot) == crc and rank < rank_of(slot))) {
+                // On failure slot is reloaded, and may now hold a lower rank
+                // or another checksum.
+                if (slots_[i].compare_exchange_weak(slot, entry)) {
+                    return;
+                }
+            }
+
+            if (crc_of(slot) == crc) {
+                return;
+            }
+        }
+    }
+
+    /* tests */
+    static TestStat test();
+};
+
+}  /* elfin */
+
+#endif  /* end of include guard: FIRST_RANK_TABLE_H_ */
@@ -0,0 +1,120 @@
+#ifndef FITNESS_CACHE_H_
+#define FITNESS_CACHE_H_
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace elfin {
+
+struct TestStat;
+
+// Scores of teams evaluated before, keyed by a fingerprint of their modules
+// and positions, so that duplicate children are not scored again.
+//
+// Slots are set associative: a key can only be in the WAYS slots of its
+// bucket. When all of them are taken, the CLOCK hand of the bucket evicts the
+// first slot that was not hit since the hand last passed it. Nothing locks.
+// Each slot's key doubles as a sequence number, so a reader never returns a
+// value that a writer was replacing. Hit counts are kept per shard of
+// buckets so that threads do not contend on one counter.
+class FitnessCache {
+public:
+    /* types */
+    typedef uint64_t Key;
+
+    struct Entry {
+        float score = INFINITY;
+        uint32_t ref_id = 0;
+    };
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t inserts = 0;
+        size_t evictions = 0;
+
+        float hit_rate() const {
+            size_t const lookups = hits + misses;
+            return lookups ? (float) hits / lookups : 0;
+        }
+    };
+
+    static size_t const WAYS = 8;
+    static size_t const N_SHARDS = 64;
+
+protected:
+    /* types */
+    struct Slot {
+        std::atomic<Key> key;
+        std::atomic<uint64_t> value;
+    };
+
+    struct alignas(64) Bucket {
+        Slot slots[WAYS];
+        std::atomic<uint8_t> referenced;  // Bit per way.
+        std::atomic<uint8_t> hand;
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<size_t> hits;
+        std::atomic<size_t> misses;
+        std::atomic<size_t> inserts;
+        std::atomic<size_t> evictions;
+    };
+
+    // Keys that no fingerprint maps to.
+    static Key const EMPTY = 0;
+    static Key const BUSY = 1;
+
+    /* data */
+    size_t mask_ = 0;
+    std::unique_ptr<Bucket[]> buckets_;
+    std::unique_ptr<Shard[]> shards_;
+
+    /* accessors */
+    static Key normalize(Key const key) { return key < 2 ? key + 2 : key; }
+    Bucket& bucket_of(Key const key) const { return buckets_[key & mask_]; }
+    Shard& shard_of(Key const key) const {
+        return shards_[key & mask_ & (N_SHARDS - 1)];
+    }
+
+public:
+    /* ctors */
+    // Holds at least capacity entries; 0 disables the cache.
+    FitnessCache(size_t const capacity);
+
+    /* accessors */
+    bool enabled() const { return bool(buckets_); }
+    size_t capacity() const { return enabled() ? (mask_ + 1) * WAYS : 0; }
+    Stats stats() const;
+    // Fills entry if key was cached.
+    bool lookup(Key const key, Entry& entry) const;
+
+    /* modifiers */
+    // May drop the entry if other threads keep the bucket busy.
+    void insert(Key const key, Entry const& entry);
+
+    /* free functions */
+    // Folds the next word of a fingerprint into key (splitmix64 finalizer).
+    static Key mix(Key const key, uint64_t const word) {
+        uint64_t z = key ^ (word + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2));
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    static Key mix(Key const key, float const word) {
+        uint32_t bits;
+        std::memcpy(&bits, &word, sizeof(bits));
+        return mix(key, (uint64_t) bits);
+    }
+
+    /* tests */
+    static TestStat test();
+};
+
+}  /* elfin */
+
+#endif  /* end of include guard: FITNESS_CACHE_H_ */
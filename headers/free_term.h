@@ -7,6 +7,7 @@
 
 #include "term_type.h"
 #include "proto_link.h"
+#include "random_utils.h"
 
 namespace elfin {
 
@@ -41,7 +42,7 @@ struct FreeTerm : public Printable {
     /* accessors */
     bool operator==(FreeTerm const& other) const;
     bool operator!=(FreeTerm const& other) const { return not this->operator==(other); }
-    ProtoLink const& random_proto_link(uint32_t& seed) const;
+    ProtoLink const& random_proto_link(random::Stream& seed) const;
     BridgeList find_bridges(FreeTerm const& dst) const;
     ProtoLink const* find_link_to(FreeTerm const& dst) const;
     ProtoTerm const& get_ptterm() const;
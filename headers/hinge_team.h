@@ -30,9 +30,11 @@ protected:
     virtual NodeKey get_tip(bool const mutable_hint) const;
     virtual void mutation_invariance_check() const;
     virtual bool is_mutable(NodeKey const tip) const;
+    virtual bool in_spec_frame() const;
     virtual void postprocess_json(JSON& output) const;
 
     /* modifiers */
+    virtual void unshare_nodes();
     virtual void reset();
     virtual void virtual_copy(NodeTeam const& other);
     virtual void fix_limb_transforms(Link const& arrow);
@@ -45,7 +47,7 @@ protected:
 public:
     /* ctors */
     HingeTeam(WorkArea const* const wa,
-              uint32_t const seed,
+              random::Stream const& seed,
               bool const loose = false);
     HingeTeam(HingeTeam const& other);
     HingeTeam(HingeTeam&& other);
@@ -53,9 +55,17 @@ public:
     /* dtors */
     virtual ~HingeTeam();
 
+    /* accessors */
+    virtual void write_checkpoint(checkpoint::Writer& writer) const;
+
     /* modifiers */
     HingeTeam& operator=(HingeTeam const& other);
     HingeTeam& operator=(HingeTeam && other);
+    virtual void read_checkpoint(checkpoint::Reader& reader);
+    virtual void pack_points(scoring::PointBatch& batch,
+                             size_t const set) const;
+    virtual void finish_score(scoring::PointBatch const& batch,
+                              size_t const set);
 
     /* tests */
     static TestStat test();
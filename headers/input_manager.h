@@ -17,11 +17,16 @@ struct Cutoffs {
     size_t non_survivors = 0;
 };
 
+// Cutoffs for a population of pop_size teams at the configured survive rate.
+Cutoffs calc_cutoffs(size_t const pop_size);
+
 struct GATimes {
     double evolve_time = 0.0f;
+    double evolve_idle_time = 0.0f;  // Mean over threads.
     double score_time = 0.0f;
     double rank_time = 0.0f;
     double select_time = 0.0f;
+    double refine_time = 0.0f;
 };
 
 class InputManager {
@@ -9,7 +9,7 @@ namespace elfin {
 /* Fwd Decl */
 class Node;
 typedef std::unique_ptr<Node> NodeSP;
-typedef std::unordered_map<Node const*, Node*> NodeKeyMap;
+class NodePool;
 class PathGenerator;
 
 class Link : public Printable {
@@ -22,6 +22,8 @@ protected:
 public:
 
     /* ctors */
+    // Empty link, e.g. an unused slot of a LinkList.
+    Link() : prototype_(nullptr) {}
     Link(FreeTerm const& src,
          ProtoLink const* prot,
          FreeTerm const& dst);
@@ -41,7 +43,9 @@ public:
     PathGenerator gen_path() const;
 
     /* modifiers */
-    void update_node_ptrs(NodeKeyMap const& nam);
+    // Points src and dst at their counterparts in pool, which was copied from
+    // the pool owning them.
+    void update_node_ptrs(NodePool const& pool);
 
     /* printers */
     virtual void print_to(std::ostream& os) const;
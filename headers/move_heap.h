@@ -20,6 +20,11 @@ public:
         return value;
     }
 
+    // The heap as laid out, so that it can be saved and restored as it is.
+    Container const& container() const { return c; }
+    // Takes a container that is already a heap under Compare.
+    void assign(Container&& container) { c = std::move(container); }
+
 protected:
     using std::priority_queue<T, Container, Compare>::c;
     using std::priority_queue<T, Container, Compare>::comp;
@@ -2,15 +2,20 @@
 #define MUTATION_H_
 
 #include <unordered_map>
+#include <array>
+#include <cmath>
 
 #include "free_term.h"
+#include "json.h"
 
 namespace elfin {
 
 /* Fwd Decl */
+struct TestStat;
 class Node;
 typedef Node const* NodeKey;
 class Link;
+namespace checkpoint { class Writer; class Reader; }
 
 namespace mutation {
 
@@ -29,6 +34,108 @@ GEN_ENUM_AND_STRING(Mode, ModeNames, FOREACH_MODES);
 typedef std::unordered_map<Mode, size_t> Counter;
 typedef std::vector<Mode> ModeList;
 
+size_t const N_MODES = static_cast<size_t>(Mode::_ENUM_SIZE);
+
+// What one evolve() call did: the modes it tried, how long each took and how
+// many nodes each touched, the mode that succeeded (NONE if the team had to
+// be randomized), and the scores of the mother and of the child once scored.
+struct Record {
+    Mode mode = Mode::NONE;
+    uint32_t tried = 0;  // Bit per mode.
+    std::array<float, N_MODES> cost_ns{};
+    std::array<float, N_MODES> cost_nodes{};
+    float parent_score = INFINITY;
+    float child_score = INFINITY;
+
+    /* accessors */
+    // Relative improvement of the child over its mother, 0 if none.
+    float gain() const;
+
+    /* modifiers */
+    void clear() { *this = Record(); }
+    void add_try(Mode const mode, float const ns, float const nodes) {
+        tried |= 1u << static_cast<size_t>(mode);
+        cost_ns[static_cast<size_t>(mode)] += ns;
+        cost_nodes[static_cast<size_t>(mode)] += nodes;
+    }
+};
+
+// Per mode sums over Records. Children that no mode could mutate are
+// counted under NONE.
+class Stats {
+public:
+    /* types */
+    struct ModeStats {
+        double tries = 0;
+        double successes = 0;
+        double improvements = 0;
+        double cost_ns = 0;
+        double cost_nodes = 0;
+        double gain = 0;
+    };
+
+protected:
+    /* data */
+    std::array<ModeStats, N_MODES> modes_;
+
+public:
+    /* accessors */
+    ModeStats const& at(Mode const mode) const {
+        return modes_.at(static_cast<size_t>(mode));
+    }
+    JSON to_json() const;
+
+    /* modifiers */
+    void add(Record const& record);
+    Stats& operator+=(Stats const& other);
+    // Scales all sums so that older records count less.
+    void decay(double const factor);
+};
+
+// Picks the order in which evolve() tries mutation modes.
+//
+// Uniform scheduling draws each next mode with equal odds. Adaptive
+// scheduling treats the modes as arms of a bandit whose payoff is fitness
+// gain per node touched in evolve(), discounted over generations. Nodes
+// rather than time are counted so that a seed always gives the same run. A
+// mode is drawn with odds proportional to its payoff relative to the best
+// mode plus a UCB1 exploration bonus, so that no mode is starved. Modes
+// without recent tries are drawn like the best mode until they have some.
+class Scheduler {
+protected:
+    /* data */
+    bool const adaptive_;
+    Stats recent_;
+    Stats totals_;
+    std::array<float, N_MODES> weights_;
+
+public:
+    /* ctors */
+    Scheduler(bool const adaptive);
+
+    /* accessors */
+    bool adaptive() const { return adaptive_; }
+    float weight(Mode const mode) const {
+        return weights_.at(static_cast<size_t>(mode));
+    }
+    // Everything recorded since construction.
+    Stats const& totals() const { return totals_; }
+    // Recent mean ns that evolve() spent on a child, over all the modes it
+    // tried. A default before anything is recorded.
+    float child_cost_ns() const;
+    // Recent mean nodes that evolve() touched for a child, like
+    // child_cost_ns(). Unlike time, this is the same on every run.
+    float child_cost_nodes() const;
+    // Removes and returns the next mode to try.
+    Mode pop(ModeList& modes, random::Stream& seed) const;
+    void write_checkpoint(checkpoint::Writer& writer) const;
+
+    /* modifiers */
+    // Takes in the scored children of a generation and reweighs modes.
+    void update(std::vector<Record> const& records);
+    void read_checkpoint(checkpoint::Reader& reader);
+};
+
 struct DeletePoint {
     //
     // [neighbor1] <--link1-- [delete_node] --link2--> [neighbor2]
@@ -95,6 +202,7 @@ struct CrossPoint {
 /* free functions */
 ModeList gen_mode_list();
 Counter gen_counter();
+TestStat test();
 
 static inline void bad_mode(Mode mode) {
     TRACE(mode == mode, "Bad Mutation Mode: %s\n", ModeToCStr(mode));
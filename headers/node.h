@@ -2,7 +2,8 @@
 #define NODE_H_
 
 #include <memory>
-#include <list>
+#include <array>
+#include <algorithm>
 
 #include "proto_module.h"
 #include "geometry.h"
@@ -15,24 +16,55 @@ class Node;
 typedef std::unique_ptr<Node> NodeSP;
 typedef Node const* NodeKey;
 
-class Node : public Printable {
+// Links of a Node, stored inline so that copying a Node does not allocate.
+// A node on a path has at most two neighbours.
+class LinkList {
+public:
+    /* types */
+    static size_t const MAX_LINKS = 2;
+
 protected:
-    //
-    // Note: Use of vector as container for neighbors (LinkList)
-    //
-    // I chose to use vector because as far as we are concerned now, modules
-    // have very few termini e.g. max 4 at the time of writing. Although it's
-    // O(n) to access the wanted FreeTerm, using more complex structure to
-    // support O(1) operations is probably not worth the memory/dev time due
-    // to how tiny the vectors are.
-    //
-    // If in the future the number of termini per module does increase
-    // significantly, it might be advisable to switch to VectorMap or
-    // something better.
-    //
+    /* data */
+    std::array<Link, MAX_LINKS> links_;
+    size_t size_ = 0;
+
+public:
+    /* accessors */
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    Link const* begin() const { return links_.data(); }
+    Link const* end() const { return links_.data() + size_; }
+    Link* begin() { return links_.data(); }
+    Link* end() { return links_.data() + size_; }
+
+    // Found by ADL only, so they don't hide std::begin and std::end.
+    friend Link const* begin(LinkList const& ll) { return ll.begin(); }
+    friend Link const* end(LinkList const& ll) { return ll.end(); }
+    friend Link* begin(LinkList& ll) { return ll.begin(); }
+    friend Link* end(LinkList& ll) { return ll.end(); }
 
+    /* modifiers */
+    void push_back(Link const& link) {
+        TRACE(size_ == MAX_LINKS,
+              "Node cannot have more than %zu links\n", MAX_LINKS);
+        links_[size_++] = link;
+    }
+    // Keeps the order of the remaining links.
+    void erase(Link const* const pos) {
+        std::move(links_.begin() + (pos - begin()) + 1,
+                  links_.begin() + size_,
+                  links_.begin() + (pos - begin()));
+        size_--;
+    }
+};
+
+class Node : public Printable {
+    friend class NodePool;
+
+protected:
     /* data */
-    std::list<Link> links_;
+    LinkList links_;
+    size_t index_ = 0;  // Slot in the owning NodePool.
 
 public:
     /* data */
@@ -46,20 +78,21 @@ public:
     NodeSP clone() const { return std::make_unique<Node>(*this); }
 
     /* accessors */
-    std::list<Link> const& links() const { return links_; }
+    LinkList const& links() const { return links_; }
     Link const* find_link_to(NodeKey dst_node) const;
+    size_t index() const { return index_; }
 
     /* modifiers */
     void add_link(
         FreeTerm const& src,
         ProtoLink const* proto_link,
         FreeTerm const& dst) {
-        links_.emplace_back(src, proto_link, dst);
+        links_.push_back(Link(src, proto_link, dst));
     }
     void add_link(Link const& link) {
-        links_.emplace_back(link);
+        links_.push_back(link);
     }
-    void update_link_ptrs(NodeKeyMap const& nam);
+    void update_link_ptrs(NodePool const& pool);
     void remove_link(FreeTerm const& fc);
 
     /* printers */
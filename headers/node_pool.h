@@ -0,0 +1,112 @@
+#ifndef NODE_POOL_H_
+#define NODE_POOL_H_
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <optional>
+
+#include "node.h"
+
+namespace elfin {
+
+/* Fwd Decl */
+namespace checkpoint {
+class Writer;
+class Reader;
+}  /* checkpoint */
+
+// Storage for NodePool chunks, carved out of large slabs instead of being
+// allocated one by one. Each thread keeps a list of free chunks threaded
+// through the chunks themselves, so acquire() and release() rarely need more
+// than that list. A thread that frees more chunks than it uses, such as one
+// destroying a population, passes the surplus to a shared pool, which other
+// threads draw from before taking a new slab. Slabs are kept for the life of
+// the process and reused by later populations.
+class NodeArena {
+public:
+    /* types */
+    // One huge page on x86-64 Linux, where slabs are advised to use them.
+    static size_t const SLAB_BYTES = 2 << 20;
+
+    /* accessors */
+    static size_t bytes_in_use();
+    static size_t bytes_reserved();
+
+    /* modifiers */
+    static void* acquire();
+    static void release(void* const chunk);
+};
+
+// Owns the nodes of a team in fixed-size chunks of slots. A node keeps its
+// address until erased, and records the index of its slot. A pool copied
+// from another has the same nodes in the same slots, so a NodeKey of the
+// other pool maps to this pool's counterpart by index instead of through a
+// lookup table.
+class NodePool {
+public:
+    /* types */
+    static size_t const CHUNK_SIZE = 32;
+    typedef std::array<std::optional<Node>, CHUNK_SIZE> Chunk;
+
+protected:
+    /* types */
+    struct ChunkDeleter {
+        void operator()(Chunk* const chunk) const {
+            chunk->~Chunk();
+            NodeArena::release(chunk);
+        }
+    };
+    typedef std::unique_ptr<Chunk, ChunkDeleter> ChunkUP;
+
+    /* data */
+    std::vector<ChunkUP> chunks_;
+    std::vector<size_t> free_slots_;
+    size_t n_slots_ = 0;  // Slots handed out since clear(), erased or not.
+    size_t size_ = 0;
+
+    /* accessors */
+    std::optional<Node> const& slot(size_t const index) const {
+        return (*chunks_[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+    }
+    std::optional<Node>& slot(size_t const index) {
+        return (*chunks_[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+    }
+
+    /* modifiers */
+    void add_chunk();
+
+public:
+    /* accessors */
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // Mutable access to a node of this pool.
+    Node* get(NodeKey const nk);
+    // Node of this pool in the slot that other_nk has in its own pool.
+    NodeKey counterpart(NodeKey const other_nk) const;
+
+    // Bytes of chunk storage held, whether slots are used or not.
+    size_t bytes() const { return chunks_.size() * sizeof(Chunk); }
+
+    // Writes nodes slot by slot, referring to nodes by slot index, so that
+    // read_checkpoint() restores the same slots.
+    void write_checkpoint(checkpoint::Writer& writer) const;
+    void write_node(checkpoint::Writer& writer, NodeKey const nk) const;
+    NodeKey read_node(checkpoint::Reader& reader) const;
+    void write_term(checkpoint::Writer& writer, FreeTerm const& term) const;
+    FreeTerm read_term(checkpoint::Reader& reader) const;
+
+    /* modifiers */
+    Node* emplace(ProtoModule const* const prototype, Transform const& tx);
+    void erase(NodeKey const nk);
+    // Keeps chunks for reuse.
+    void clear();
+    // Copies nodes slot by slot, reusing this pool's chunks, then points
+    // their links at nodes of this pool.
+    void copy(NodePool const& other);
+    void read_checkpoint(checkpoint::Reader& reader);
+};
+
+}  /* elfin */
+
+#endif  /* end of include guard: NODE_POOL_H_ */
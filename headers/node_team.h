@@ -14,6 +14,8 @@ namespace elfin {
 class NodeTeam;
 typedef std::unique_ptr<NodeTeam> NodeTeamSP;
 class WorkArea;
+namespace scoring { class PointBatch; }
+namespace checkpoint { class Writer; class Reader; }
 
 
 class NodeTeam : public Printable {
@@ -47,15 +49,18 @@ public:
     };
 
     /* data */
-    uint32_t seed_;
+    random::Stream seed_;
     float collision_penalty_ = 0.0f;
+    // NUMA node expected to have built the nodes of this team, by the cost
+    // of its rank. See parallel::task_nodes().
+    size_t home_node_ = 0;
 
     /* ctors */
-    NodeTeam(WorkArea const* const wa, uint32_t const seed);
+    NodeTeam(WorkArea const* const wa, random::Stream const& seed);
     NodeTeam(NodeTeam const& other);
     NodeTeam(NodeTeam&& other);
     static NodeTeamSP create_team(WorkArea const* const work_area,
-                                  uint32_t const seed);
+                                  random::Stream const& seed);
     void copy(NodeTeam const& other) { virtual_copy(other); }
     NodeTeamSP clone() const { return NodeTeamSP(virtual_clone()); }
 
@@ -66,13 +71,36 @@ public:
     float score() const { return score_; }
     Crc32 checksum() const { return checksum_; }
     virtual size_t size() const = 0;
+    // Writes what evolve() and scoring depend on, to resume from later.
+    virtual void write_checkpoint(checkpoint::Writer& writer) const;
 
     /* modifiers */
     NodeTeam& operator=(NodeTeam const& other);
     NodeTeam& operator=(NodeTeam&& other);
     virtual void randomize() = 0;
-    virtual mutation::Mode evolve(NodeTeam const& mother,
-                                  NodeTeam const& father) = 0;
+    // Leaves the team unscored; see prepare_score(). Modes are tried in the
+    // order drawn by scheduler, and what they cost is written to record.
+    virtual void evolve(NodeTeam const& mother,
+                        NodeTeam const& father,
+                        mutation::Scheduler const& scheduler,
+                        mutation::Record& record) = 0;
+    // Memetic step on a scored team: tries up to budget neighbors one
+    // delete, insert or swap away, and becomes the best of them if it beats
+    // the team. Returns whether it did. Moves are drawn from seed_ alone.
+    virtual bool local_search(size_t const budget) = 0;
+
+    // Batched scoring as driven by Population::score(). prepare_score() does
+    // whatever needs to happen before scoring and returns false if the team
+    // is already scored (e.g. unreachable). pack_points() writes size()
+    // points into the batch and picks the references to score against.
+    // finish_score() reads the batch scores back.
+    virtual bool prepare_score() = 0;
+    virtual void pack_points(scoring::PointBatch& batch,
+                             size_t const set) const = 0;
+    virtual void finish_score(scoring::PointBatch const& batch,
+                              size_t const set) = 0;
+    // Restores a team that create_team() made for the same work area.
+    virtual void read_checkpoint(checkpoint::Reader& reader);
 
     /* printers */
     virtual JSON to_json() const = 0;
@@ -13,7 +13,11 @@ struct Options {
     std::string output_suffix = "_sol.json";
     std::string config_file = "";
     std::string output_dir = "output";
+    // Prior solutions to build part of the initial population from, in the
+    // output format.
+    std::string seed_solutions = "";
     std::string radius_type = "max_ca_dist";
+    std::string rmsd_engine = "rosetta";
 
     size_t len_dev = 3;
 
@@ -24,11 +28,28 @@ struct Options {
 
     /* GA parameters */
     uint32_t seed = 0x1337cafe;
+    std::string ga_mode = "generational";
+    std::string ga_mutation_schedule = "adaptive";
     size_t ga_pop_size = 8096;
     size_t ga_max_iters = 0;
     size_t ga_restart_trigger = 10;
     size_t ga_max_restarts = 10;
     float ga_survive_rate = 0.05f;
+    float seed_rate = 0.5f;  // Share of the initial population seeded.
+
+    // Island model: the population is split into ga_islands sub-populations
+    // that evolve independently and exchange their best teams.
+    size_t ga_islands = 1;
+    size_t ga_migration_interval = 10;
+    size_t ga_migration_size = 2;
+    std::string ga_migration_topology = "ring";
+
+    // Memetic stage of the generational GA: after selection, each of the
+    // best ga_local_search_elites survivors is replaced by the best of up to
+    // ga_local_search_budget neighbors one delete, insert or swap away, if
+    // that is better. 0 elites disables it.
+    size_t ga_local_search_elites = 0;
+    size_t ga_local_search_budget = 64;
 
     // Use a small number but not exactly 0.0 because of imprecise float
     // comparison
@@ -37,9 +58,23 @@ struct Options {
     bool run_tests = false;
 
     size_t n_workers = 0;
+    // Keeps each worker thread on one NUMA node, in blocks of consecutive
+    // threads per node.
+    bool pin_threads = false;
+    std::string numa_policy = "none";
     int device = 0;
     size_t keep_n = 3;
 
+    // Scores kept per work area so that duplicate teams are not scored
+    // again. 0 disables the cache.
+    size_t fitness_cache_size = 1 << 18;
+
+    // Generations between checkpoints of the solver state in output_dir. 0
+    // disables them. With resume, work areas continue from their last
+    // checkpoint, if any.
+    size_t checkpoint_interval = 0;
+    bool resume = false;
+
     bool dry_run = false;
 };
 
@@ -3,6 +3,9 @@
 
 #include <omp.h>
 
+#include <vector>
+#include <functional>
+
 #include "jutil.h"
 
 /* OMP Macros */
@@ -19,10 +22,58 @@ inline long TIMING_END(char const* section_name, double const start_time) {
 
 namespace elfin {
 
+struct TestStat;
+
 namespace parallel {
 
+// Time each thread spent running tasks, and the rest of the run spent
+// looking for tasks or waiting for the other threads.
+struct ThreadTimes {
+    double wall_ms = 0;
+    std::vector<double> busy_ms;
+    size_t steals = 0;
+
+    /* accessors */
+    double idle_ms(size_t const thread) const {
+        return wall_ms - busy_ms.at(thread);
+    }
+    double mean_idle_ms() const;
+    double max_idle_ms() const;
+    void print(char const* section_name) const;
+};
+
+// Runs task(i) for every i in [0, n) on a team of omp_get_max_threads()
+// threads, and returns how busy each was.
+//
+// Indices are cut into contiguous chunks of about equal cost() and dealt out
+// in order to per-thread deques, several chunks per thread. Threads take
+// chunks from the front of their own deque, and once it runs dry, steal from
+// the back of the others', those on the same NUMA node first. Costs only
+// need to be right relative to one another.
+ThreadTimes run_tasks(size_t const n,
+                      std::function<float(size_t)> const& cost,
+                      std::function<void(size_t)> const& task);
+
+// NUMA node expected to run each of n tasks: run_tasks() cuts tasks the same
+// way, but among nodes instead of threads, so that only cost() and the number
+// of nodes matter. With pinned threads spread evenly over nodes, run_tasks()
+// deals tasks to about these nodes given the same cost(). Stolen tasks run
+// elsewhere.
+std::vector<size_t> task_nodes(size_t const n,
+                               std::function<float(size_t)> const& cost);
+
+// NUMA nodes with CPUs this process may run on, numbered from 0. One node
+// where the system does not tell.
+size_t n_nodes();
+// NUMA node of the CPU the calling thread runs on.
+size_t this_node();
+
+// Sets the number of threads, and pins them if OPTIONS.pin_threads.
 void init();
 
+/* tests */
+TestStat test();
+
 }  /* parallel */
 
 }  /* elfin */
@@ -58,6 +58,7 @@ public:
     Crc32 checksum();
     std::vector<LinkCPtr> collect_arrows();
     V3fList collect_points();
+    void collect_points(V3fList& points);  // Reuses capacity of points.
     std::vector<NodeKey> collect_keys(size_t skip = 0);
     std::vector<NodeLinkPair> collect_all(size_t skip = 0);
 
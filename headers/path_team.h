@@ -4,7 +4,8 @@
 #include <functional>
 
 #include "node_team.h"
-#include "node.h"
+#include "node_pool.h"
+#include "fitness_cache.h"
 #include "recipe.h"
 #include "path_generator.h"
 #include "work_area.h"
@@ -30,11 +31,15 @@ protected:
     typedef std::function<void(NodeKey const first_node, NodeKey const last_node)> FirstLastNodeKeyCallback;
 
     /* data */
-    std::unordered_map<NodeKey, NodeSP> nodes_;
-    std::list<FreeTerm> free_terms_;
+    // Copies share nodes until either side modifies them; see
+    // unshare_nodes(). A pool given up that way is kept for reuse.
+    std::shared_ptr<NodePool> nodes_;
+    std::shared_ptr<NodePool> spare_nodes_;
+    FreeTerms free_terms_;
     V3fList const* scored_path_ = nullptr;
-    NodeKeyMap nk_map_;
     bool align_before_export_ = true;
+    // Set by prepare_score() for finish_score() to cache the score under.
+    FitnessCache::Key fingerprint_ = 0;
 
     /* accessors */
     virtual PathTeam* virtual_clone() const;
@@ -42,9 +47,18 @@ protected:
     virtual NodeKey get_tip(bool const mutable_hint) const;
     virtual void mutation_invariance_check() const;
     virtual bool is_mutable(NodeKey const nk) const;
+    // Whether nodes are placed in the spec's frame rather than one that is
+    // aligned to it by Kabsch against scored_path_.
+    virtual bool in_spec_frame() const;
     virtual void postprocess_json(JSON& output) const;
 
     /* modifiers */
+    // Nodes about to be modified, which must not be shared.
+    NodePool& mutable_nodes();
+    std::shared_ptr<NodePool> take_spare_nodes();
+    // Gives this team its own copy of shared nodes, remapping the NodeKeys
+    // it holds.
+    virtual void unshare_nodes();
     virtual void reset();
     virtual void virtual_copy(NodeTeam const& other);
     void remove_free_terms(NodeKey const node);
@@ -53,7 +67,7 @@ protected:
                      bool const innert = false,
                      size_t const n_ft_to_add = 2,
                      FreeTerm const* const exclude_ft = nullptr);
-    NodeKey grow_tip(FreeTerm const& free_term_a,
+    NodeKey grow_tip(FreeTerm const free_term_a,
                      ProtoLink const* pt_link = nullptr,
                      bool const innert = false);
     virtual void fix_limb_transforms(Link const& arrow);
@@ -61,6 +75,13 @@ protected:
     virtual void calc_checksum();
     virtual void calc_score();
     virtual void penalize_collision();
+    // Hash of everything the score depends on: the modules in path order,
+    // their positions and the collision penalty.
+    FitnessCache::Key calc_fingerprint() const;
+    // Takes the score of an identical team if one was cached, computing
+    // fingerprint_ either way.
+    bool load_cached_score();
+    void save_cached_score() const;
     // For testing: builds node team from recipe and returns the starting node.
     virtual void virtual_implement_recipe(tests::Recipe const& recipe,
                                           FirstLastNodeKeyCallback const& postprocessor,
@@ -68,7 +89,7 @@ protected:
 public:
     /* ctors */
     PathTeam(WorkArea const* const wa,
-             uint32_t const seed);
+             random::Stream const& seed);
     PathTeam(PathTeam const& other);
     PathTeam(PathTeam&& other);
 
@@ -76,15 +97,25 @@ public:
     virtual ~PathTeam();
 
     /* accessors */
-    virtual size_t size() const { return nodes_.size(); }
+    virtual size_t size() const { return nodes_->size(); }
     PathGenerator gen_path() const;
+    virtual void write_checkpoint(checkpoint::Writer& writer) const;
 
     /* modifiers */
     PathTeam& operator=(PathTeam const& other);
     PathTeam& operator=(PathTeam && other);
     virtual void randomize();
-    virtual mutation::Mode evolve(NodeTeam const& mother,
-                                  NodeTeam const& father);
+    virtual void evolve(NodeTeam const& mother,
+                        NodeTeam const& father,
+                        mutation::Scheduler const& scheduler,
+                        mutation::Record& record);
+    virtual bool local_search(size_t const budget);
+    virtual bool prepare_score();
+    virtual void pack_points(scoring::PointBatch& batch,
+                             size_t const set) const;
+    virtual void finish_score(scoring::PointBatch const& batch,
+                              size_t const set);
+    virtual void read_checkpoint(checkpoint::Reader& reader);
     void implement_recipe(tests::Recipe const& recipe,
                           Transform const& shift_tx = Transform()) {
         virtual_implement_recipe(recipe, FirstLastNodeKeyCallback(), shift_tx);
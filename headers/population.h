@@ -6,34 +6,92 @@
 
 #include "node_team.h"
 #include "work_area.h"
+#include "scoring.h"
+#include "input_manager.h"
+#include "seeding.h"
+#include "checkpoint.h"
 
 namespace elfin {
 
 class Population {
-protected:
-    /* type */
+public:
+    /* types */
     typedef std::vector<NodeTeamSP> NodeTeams;
 
+protected:
     /* data */
+    Cutoffs const cutoffs_;
     NodeTeams teams[2];
     NodeTeams* front_buffer_ = nullptr;
     NodeTeams const* back_buffer_ = nullptr;
+    scoring::PointBatch batch_;  // Reused across generations.
+
+    // Teams draw from streams keyed by key_, the generation and their rank,
+    // so that no stream depends on the order of any other.
+    uint64_t key_ = 0;
+    uint64_t generation_ = 0;
+
+    // Orders the mutation modes tried by evolve(), learning from the records
+    // of the children made since.
+    mutation::Scheduler scheduler_;
+    std::vector<mutation::Record> mutation_records_;
+
+    // (score, index) pairs and the reordered teams of rank(), reused across
+    // generations.
+    std::vector<std::pair<float, size_t>> ranking_;
+    NodeTeams ranked_teams_;
+    // Length of the front buffer prefix that rank() sorted. Every team past
+    // it scores no better than those within.
+    size_t n_ranked_ = 0;
+
+    /* accessors */
+    random::Stream stream_of(size_t const individual) const;
+
+    /* modifiers */
+    // Rebuilds seeds into the front of teams and fills up to
+    // OPTIONS.seed_rate of them with their mutants, then sorts teams so that
+    // the best become the first survivors.
+    void plant_seeds(NodeTeams& teams, seeding::Seeds const& seeds);
 
 public:
     /* ctors */
-    Population(WorkArea const* work_area, uint32_t& seed);
+    Population(WorkArea const* work_area,
+               uint64_t const key,
+               Cutoffs const& cutoffs = CUTOFFS,
+               seeding::Seeds const& seed_solutions = seeding::Seeds());
+    // Resumes a population saved by write_checkpoint().
+    Population(WorkArea const* work_area,
+               checkpoint::Reader& reader,
+               Cutoffs const& cutoffs = CUTOFFS);
 
     /* dtors */
     virtual ~Population();
 
     /* accessors */
+    Cutoffs const& cutoffs() const { return cutoffs_; }
+    mutation::Scheduler const& scheduler() const { return scheduler_; }
     NodeTeams const* front_buffer() const { return front_buffer_; }
     NodeTeams const* back_buffer() const { return back_buffer_; }
+    // Writes both buffers and the random keys, between generations.
+    void write_checkpoint(checkpoint::Writer& writer) const;
 
     /* modifiers */
     void evolve();
+    // Steady state alternative to evolve(), score() and select(). Threads
+    // each keep making a child and replacing the worst team with it, until
+    // there have been as many children as evolve() makes in a generation.
+    // Only the front buffer is used.
+    void evolve_steady_state();
+    void score();
     void rank();
     void select();
+    // Memetic stage after select(): runs PathTeam local search on the best
+    // OPTIONS.ga_local_search_elites survivors in parallel, replacing those
+    // whose best neighbor is not already a survivor.
+    void refine();
+    // Lets migrants from other populations replace the worst survivors
+    // they beat. Call after select().
+    void immigrate(NodeTeams const& migrants);
     void swap_buffer();
 };
 
@@ -2,6 +2,9 @@
 #define RANDOM_UTILS_H_
 
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
 #include <random>
 
 #include "debug_utils.h"
@@ -12,13 +15,126 @@ struct TestStat;
 
 namespace random {
 
-static inline float get_dice_0to1(uint32_t& seed) {
-    return (float) rand_r(&seed) / RAND_MAX;
+//
+// Counter-based random numbers in the style of Philox4x32-10 (Salmon et al.,
+// "Parallel Random Numbers: As Easy as 1, 2, 3"). Every number is a pure
+// function of a 64-bit key and its draw index, so streams can be keyed by
+// where they are used (e.g. run seed, restart, generation and individual)
+// rather than drawn from one another in order, and give the same numbers no
+// matter which thread draws them.
+//
+typedef std::array<uint32_t, 4> Block;
+
+static inline Block philox(uint64_t const counter,
+                           uint64_t const key,
+                           uint32_t const domain = 0) {
+    Block ctr = {(uint32_t) counter, (uint32_t) (counter >> 32), domain, 0};
+    uint32_t k0 = key, k1 = key >> 32;
+
+    for (size_t round = 0; round < 10; ++round) {
+        uint64_t const prod0 = (uint64_t) 0xD2511F53u * ctr[0];
+        uint64_t const prod1 = (uint64_t) 0xCD9E8D57u * ctr[2];
+        ctr = {(uint32_t) (prod1 >> 32) ^ ctr[1] ^ k0,
+               (uint32_t) prod1,
+               (uint32_t) (prod0 >> 32) ^ ctr[3] ^ k1,
+               (uint32_t) prod0
+              };
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+
+    return ctr;
 }
 
-static inline size_t get_dice(size_t const ceiling, uint32_t& seed) {
-    if (ceiling == 0) return 0;
-    return std::round(get_dice_0to1(seed) * (ceiling - 1));
+// Key of the child stream id of key, e.g. of an individual within a
+// generation.
+static inline uint64_t derive(uint64_t const key, uint64_t const id) {
+    // A domain of its own keeps derived keys apart from drawn numbers.
+    Block const block = philox(id, key, /*domain=*/ 1);
+    return block[0] | ((uint64_t) block[1] << 32);
+}
+
+// Draws of one key, in order of their index. The block holding the next
+// draw is kept, so each block is computed once for its four draws. Plain
+// data, so that it can be copied and checkpointed as it is.
+class Stream {
+protected:
+    /* data */
+    uint64_t key_ = 0;
+    uint64_t counter_ = 0;
+    Block block_;
+
+public:
+    /* ctors */
+    Stream(uint64_t const key = 0, uint64_t const counter = 0) :
+        key_(key),
+        counter_(counter),
+        block_(philox(counter / 4, key)) {}
+
+    /* accessors */
+    uint64_t key() const { return key_; }
+    uint64_t counter() const { return counter_; }
+    bool operator==(Stream const& other) const {
+        return key_ == other.key_ and counter_ == other.counter_;
+    }
+    bool operator!=(Stream const& other) const {
+        return not this->operator==(other);
+    }
+
+    /* modifiers */
+    uint32_t next() {
+        uint32_t const res = block_[counter_ % 4];
+        if (++counter_ % 4 == 0) {
+            block_ = philox(counter_ / 4, key_);
+        }
+        return res;
+    }
+
+    // Same as n calls to next(), a whole block at a time.
+    void fill(uint32_t* out, size_t n) {
+        while (n and counter_ % 4) {
+            *out++ = next();
+            n--;
+        }
+
+        for (; n >= 4; n -= 4, out += 4) {
+            for (size_t i = 0; i < 4; ++i) {
+                out[i] = block_[i];
+            }
+            counter_ += 4;
+            block_ = philox(counter_ / 4, key_);
+        }
+
+        while (n--) {
+            *out++ = next();
+        }
+    }
+};
+
+// In [0, 1), at the full resolution of float.
+static inline float to_0to1(uint32_t const bits) {
+    return (bits >> 8) * (1.0f / (1u << 24));
+}
+
+static inline float get_dice_0to1(Stream& seed) {
+    return to_0to1(seed.next());
+}
+
+// Same as n calls to get_dice_0to1().
+static inline void fill_0to1(float* out, size_t const n, Stream& seed) {
+    uint32_t bits[64];
+    for (size_t i = 0; i < n; i += 64) {
+        size_t const m = std::min(n - i, (size_t) 64);
+        seed.fill(bits, m);
+        for (size_t j = 0; j < m; ++j) {
+            out[i + j] = to_0to1(bits[j]);
+        }
+    }
+}
+
+// Uniform in [0, ceiling), for ceilings below 2^32.
+static inline size_t get_dice(size_t const ceiling, Stream& seed) {
+    return ((uint64_t) seed.next() * ceiling) >> 32;
 }
 
 
@@ -45,7 +161,7 @@ template < class Container,
                             !std::is_const<Container>::value > * = nullptr >
 static inline
 typename Container::value_type
-pop(Container& v, uint32_t& seed) {
+pop(Container& v, Stream& seed) {
     DEBUG_NOMSG(v.empty());
 
     size_t const idx = get_dice(v.size(), seed);
@@ -64,7 +180,7 @@ template < typename Container,
                                      Container >::type* = nullptr >
 static inline
 typename Container::value_type &
-pick(Container & v, uint32_t& seed) {
+pick(Container & v, Stream& seed) {
     DEBUG_NOMSG(v.empty());
     return v.at(get_dice(v.size(), seed));
 }
@@ -75,7 +191,7 @@ template < typename Container,
                                      Container >::type* = nullptr >
 static inline
 typename Container::value_type &
-pick(Container & v, uint32_t& seed) {
+pick(Container & v, Stream& seed) {
     // O(n) complexity!
     DEBUG_NOMSG(v.empty());
     auto itr = begin(v);
@@ -87,7 +203,7 @@ pick(Container & v, uint32_t& seed) {
 template<class Container>
 static inline
 typename Container::value_type const &
-pick(Container const& v, uint32_t& seed) {
+pick(Container const& v, Stream& seed) {
     return pick(const_cast<Container&>(v), seed);
 }
 
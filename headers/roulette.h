@@ -14,6 +14,9 @@ namespace elfin {
 // A vector wrapper that also stores a probability distribution from which
 // random items are drawn.
 //
+// Draws are O(1) using Vose's alias method, so build_alias_table() must be
+// called once the items are in place and before drawing.
+//
 template<typename ItemType>
 class Roulette {
 protected:
@@ -21,15 +24,27 @@ protected:
     typedef std::vector<ItemType> ItemList;
     typedef std::vector<float> CummProbDist;
 
+    // Item i is drawn with probability prob out of its column, and alias
+    // otherwise.
+    struct AliasColumn {
+        float prob;
+        uint32_t alias;
+    };
+    typedef std::vector<AliasColumn> AliasTable;
+
     /* data */
     ItemList items_;
     CummProbDist cpd_;
+    std::vector<float> probs_;
     float total_ = 0;
+    AliasTable alias_table_;
 
     /* modifiers */
     void accumulate_prob(float const prob) {
         total_ += prob;
         cpd_.push_back(total_);
+        probs_.push_back(prob);
+        alias_table_.clear();
     }
 public:
     /* ctors */
@@ -49,22 +64,61 @@ public:
     /* accessors */
     ItemList const& items() const { return items_; }
     CummProbDist const& cpd() const { return cpd_; }
-    size_t total() const { return total_; }
-    ItemType const& draw(uint32_t& seed) const {
+    float total() const { return total_; }
+    ItemType const& draw(random::Stream& seed) const {
         TRACE_NOMSG(cpd_.empty());
-        DEBUG(cpd_.size() != items_.size(),
-              "cml_sum size=%zu but container size=%zu\n",
-              cpd_.size(),
+        TRACE(alias_table_.size() != items_.size(),
+              "Alias table size=%zu but container size=%zu\n",
+              alias_table_.size(),
               items_.size());
-        auto itr = std::upper_bound(
-                       begin(cpd_),
-                       end(cpd_),
-                       random::get_dice(total_, seed)
-                   );
-        return items_.at(itr - begin(cpd_));
+        size_t const column = random::get_dice(alias_table_.size(), seed);
+        AliasColumn const& ac = alias_table_[column];
+        return items_[random::get_dice_0to1(seed) < ac.prob ?
+                      column :
+                      ac.alias];
     }
 
     /* modifiers */
+    // Leaves the table empty if there is nothing to draw, i.e. all
+    // probabilities are 0.
+    void build_alias_table() {
+        alias_table_.clear();
+        size_t const n = probs_.size();
+        if (not (total_ > 0)) return;
+
+        // Probabilities scaled so that they average 1.
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        uint32_t fallback = 0;
+        for (size_t i = 0; i < n; ++i) {
+            scaled[i] = (double) probs_[i] * n / total_;
+            (scaled[i] < 1 ? small : large).push_back(i);
+            if (probs_[i] > probs_[fallback]) {
+                fallback = i;
+            }
+        }
+
+        alias_table_.resize(n);
+        while (not small.empty() and not large.empty()) {
+            uint32_t const s = small.back();
+            uint32_t const l = large.back();
+            small.pop_back();
+            large.pop_back();
+
+            alias_table_[s] = {(float) scaled[s], l};
+            scaled[l] = (scaled[l] + scaled[s]) - 1;
+            (scaled[l] < 1 ? small : large).push_back(l);
+        }
+
+        // What is left is 1 up to rounding, except items of probability 0
+        // that rounding left behind.
+        for (auto const list : {&small, &large}) {
+            for (uint32_t const i : *list) {
+                alias_table_[i] = {probs_[i] > 0 ? 1.0f : 0.0f, fallback};
+            }
+        }
+    }
+
     void push_back(float const prob, ItemType const& item) {
         accumulate_prob(prob);
         items_.push_back(item);
@@ -73,7 +127,9 @@ public:
     void clear() {
         items_.clear();
         cpd_.clear();
+        probs_.clear();
         total_ = 0;
+        alias_table_.clear();
     }
 
     template <class ... Args>
@@ -84,8 +140,10 @@ public:
 
     void pop_back() {
         cpd_.pop_back();
-        total_ = cpd_.back();
+        probs_.pop_back();
+        total_ = cpd_.empty() ? 0 : cpd_.back();
         items_.pop_back();
+        alias_table_.clear();
     }
 };
 
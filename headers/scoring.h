@@ -1,6 +1,11 @@
 #ifndef SCORING_H
 #define SCORING_H
 
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <unordered_map>
+
 #include "geometry.h"
 
 namespace elfin
@@ -18,6 +23,10 @@ inline bool almost_eq(float const a, float const b) {
   return abs(a - b) < EPSILON;
 }
 
+// Selects the RMSD engine from OPTIONS.rmsd_engine: Rosetta's Kabsch port or
+// Theobald's QCP. Called by InputManager::parse().
+void init();
+
 // Resamples two point lists of arbitrary sizes, then calls Rosetta's Kabsch in
 // RMS-only mode.
 float score_aligned(V3fList const& mobile,
@@ -27,9 +36,132 @@ float score_unaligned(V3fList const& mobile,
 
 typedef decltype(score_aligned) score_func_type;
 
+// score_aligned() against two references in one pass over mobile, e.g. a
+// path guide and its reverse. Centering and e0 terms are shared.
+void score_aligned_pair(V3fList const& mobile,
+                        V3fList const& ref_a,
+                        V3fList const& ref_b,
+                        float& score_a,
+                        float& score_b);
+
 static_assert(std::is_same<score_func_type, decltype(score_unaligned)>::value,
               "score_aligned and score_unaligned must have the same signature.");
 
+// A reference path resampled to one size and moved to its center, so that
+// candidates of that size only need to center themselves.
+struct CenteredRef {
+    std::vector<double> xs, ys, zs;
+    double sq_sum = 0;  // Sum of squared distances to the center.
+
+    CenteredRef(V3fList const& points);
+};
+
+// A reference path centered at its own size and at each size it was
+// upsampled to, built once and shared by every batch scoring against it.
+class CenteredPath {
+protected:
+    /* data */
+    V3fList const* path_;
+    std::vector<CenteredRef> refs_;  // refs_[i] has path_->size() + i points.
+
+public:
+    /* ctors */
+    // upsampled[i] must be path upsampled to path.size() + 1 + i points, as
+    // in WorkArea::resampled_path_map.
+    CenteredPath(V3fList const& path, std::vector<V3fList> const& upsampled);
+
+    /* accessors */
+    V3fList const& path() const { return *path_; }
+    // Null if path was not upsampled to size.
+    CenteredRef const* find(size_t const size) const;
+};
+
+// Structure-of-arrays buffer holding the point lists of many candidates back
+// to back, so that a whole generation can be scored against the same
+// reference paths in one pass.
+class PointBatch {
+public:
+    /* types */
+    typedef uint8_t RefMask;  // Bit i requests a score against refs()[i].
+    typedef std::unordered_map<size_t, CenteredRef> CenteredRefMap;
+
+protected:
+    /* data */
+    std::vector<V3fList const*> refs_;
+    // Shared centered references, if the batch was made from them.
+    std::vector<CenteredPath const*> centered_paths_;
+    // Each reference resampled and centered by this batch, by size, for
+    // sizes not found in centered_paths_. Kept across generations, since
+    // teams tend to keep to a few sizes.
+    std::vector<CenteredRefMap> centered_refs_;
+    std::vector<size_t> offsets_ = {0};
+    std::vector<RefMask> ref_masks_;
+    std::vector<float> xs_, ys_, zs_;
+    std::vector<float> scores_;
+    float cutoff_ = INFINITY;
+
+public:
+    /* ctors */
+    PointBatch(std::vector<V3fList const*> const& refs);
+    PointBatch(std::vector<CenteredPath const*> const& centered_paths);
+
+    /* accessors */
+    std::vector<V3fList const*> const& refs() const { return refs_; }
+    std::vector<CenteredPath const*> const& centered_paths() const {
+        return centered_paths_;
+    }
+    size_t n_sets() const { return ref_masks_.size(); }
+    size_t offset(size_t const set) const { return offsets_[set]; }
+    size_t size_of(size_t const set) const {
+        return offsets_[set + 1] - offsets_[set];
+    }
+    RefMask ref_mask(size_t const set) const { return ref_masks_[set]; }
+    size_t ref_id(V3fList const* const ref) const;
+    float const* xs() const { return xs_.data(); }
+    float const* ys() const { return ys_.data(); }
+    float const* zs() const { return zs_.data(); }
+    float score(size_t const set, size_t const ref_id) const {
+        return scores_[set * refs_.size() + ref_id];
+    }
+    float cutoff() const { return cutoff_; }
+    CenteredRef const& centered_ref(size_t const ref_id,
+                                    size_t const size) const;
+
+    /* modifiers */
+    // Lays out one slot of sizes[i] points for each set. Previous content is
+    // discarded but capacity is kept across generations.
+    void resize(std::vector<size_t> const& sizes);
+    void set_point(size_t const set, size_t const i, Vector3f const& point) {
+        size_t const at = offsets_[set] + i;
+        xs_[at] = point[0];
+        ys_[at] = point[1];
+        zs_[at] = point[2];
+    }
+    void set_ref_mask(size_t const set, RefMask const mask) {
+        ref_masks_[set] = mask;
+    }
+    void set_score(size_t const set, size_t const ref_id, float const score) {
+        scores_[set * refs_.size() + ref_id] = score;
+    }
+    // Scores above cutoff need not be exact. See score_aligned_batch().
+    void set_cutoff(float const cutoff) { cutoff_ = cutoff; }
+    // Resamples and centers refs()[ref_id] to size unless already done or
+    // shared.
+    void add_centered_ref(size_t const ref_id, size_t const size);
+};
+
+// Scores every set in batch against each reference selected by its RefMask,
+// with the same result as score_aligned(). Each reference is resampled and
+// centered once per distinct set size for the life of the batch, or taken
+// from its CenteredPath, instead of once per candidate.
+// Unrequested scores are set to INFINITY.
+//
+// Before the exact solve, each score is bounded from below by the difference
+// in spread of the two centered point lists. If that bound already exceeds
+// batch.cutoff(), the bound is stored instead; it is still above the cutoff,
+// so such candidates rank behind every candidate that scored within it.
+void score_aligned_batch(PointBatch& batch);
+
 // Resamples two point lists of arbitrary sizes, then computes in-order RMS
 // without Kabsch.
 // float simple_rms(V3fList const& mobile, V3fList const& ref);
@@ -40,14 +172,17 @@ void calc_alignment(V3fList const& mobile,
                     elfin::Mat3f& rot,
                     Vector3f& tran);
 
+// Inserts points into the longest segments until there are <target> points.
+// The first overload writes into result, reusing its capacity.
+void upsample(V3fList const& points, size_t const target, V3fList& result);
+V3fList upsample(V3fList const& points, size_t const target);
+
 /* tests */
 TestStat test();
 
 // The following functions a prefixed by underscore because they're not meant
 // to be called from modules other than tests.cc.
 
-V3fList _upsample(V3fList const& points, size_t const target);
-
 // Implemetation of Kabsch algoritm for finding the best rotation matrix.
 // ---------------------------------------------------------------------------
 // mobile - mobile(i,m) are coordinates of atom m in set mobile   (input)
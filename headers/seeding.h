@@ -0,0 +1,46 @@
+#ifndef SEEDING_H_
+#define SEEDING_H_
+
+#include <string>
+#include <vector>
+
+#include "term_type.h"
+#include "recipe.h"
+#include "transform.h"
+
+namespace elfin {
+
+/* Fwd Decl */
+struct TestStat;
+class WorkArea;
+
+namespace seeding {
+
+/* types */
+// A prior solution to rebuild with PathTeam::implement_recipe(), with its
+// first node placed at shift_tx.
+struct Seed {
+    tests::Recipe recipe;
+    Transform shift_tx;
+};
+typedef std::vector<Seed> Seeds;
+
+/* free functions */
+// Reads the solutions for work_area from file. The file is either an output
+// of the solver, or maps work area names to lists of solutions directly. A
+// solution is a list of nodes as written in the output, optionally wrapped in
+// an object under "nodes". Solutions that cannot be built in work_area, e.g.
+// because the spec or database changed since, are skipped with a warning.
+//
+// Outputs of hinged work areas leave out the hinge, so it is put back in
+// front of the first node through any link that connects the two.
+Seeds load(std::string const& file, WorkArea const& work_area);
+
+/* tests */
+TestStat test();
+
+}  /* seeding */
+
+}  /* elfin */
+
+#endif  /* end of include guard: SEEDING_H_ */
@@ -0,0 +1,64 @@
+#ifndef SOLUTION_ARCHIVE_H_
+#define SOLUTION_ARCHIVE_H_
+
+#include <vector>
+#include <unordered_set>
+
+#include "work_area.h"
+
+namespace elfin {
+
+struct TestStat;
+
+// The best distinct teams found so far, at most capacity of them.
+//
+// Keeps them in a max heap (worst on top) alongside an index of their
+// checksums, so that a team is taken or turned away in O(log capacity)
+// instead of by draining the heap. The heap is the caller's, so that it
+// outlives the archive and can be checkpointed as it is.
+class SolutionArchive {
+public:
+    /* types */
+    typedef std::vector<NodeTeam const*> Candidates;
+
+protected:
+    /* data */
+    TeamSPMaxHeap& heap_;
+    size_t const capacity_;
+    std::unordered_set<Crc32> checksums_;
+
+public:
+    /* ctors */
+    // Indexes the teams already in heap.
+    SolutionArchive(TeamSPMaxHeap& heap, size_t const capacity);
+
+    /* accessors */
+    size_t size() const { return heap_.size(); }
+    size_t capacity() const { return capacity_; }
+    // Score a team has to beat to be taken, INFINITY while there is room.
+    float worst_score() const;
+    bool contains(Crc32 const checksum) const {
+        return checksums_.find(checksum) != end(checksums_);
+    }
+    bool accepts(NodeTeam const& team) const {
+        return team.score() < worst_score() and not contains(team.checksum());
+    }
+    // Those of teams that the archive would take, best first, one per
+    // checksum and at most capacity of them.
+    Candidates candidates(std::vector<NodeTeamSP> const& teams) const;
+
+    /* modifiers */
+    // Takes a clone of team if it accepts it, dropping the worst team when
+    // full.
+    bool insert(NodeTeam const& team);
+    // Takes the best of lists of candidates, e.g. one per island. Lists are
+    // filtered against the archive in parallel, then merged best first.
+    void merge(std::vector<Candidates> const& candidate_lists);
+
+    /* tests */
+    static TestStat test();
+};
+
+}  /* elfin */
+
+#endif  /* end of include guard: SOLUTION_ARCHIVE_H_ */
@@ -3,6 +3,7 @@
 
 // #define USE_EIGEN
 
+#include <array>
 #include <sstream>
 
 #ifdef USE_EIGEN
@@ -41,6 +42,9 @@ private:
 #endif  /* ifndef USE_EIGEN */
 
 public:
+    /* types */
+    // Rows of the rotation, each followed by the translation along it.
+    typedef std::array<float, 12> Floats;
 
     /* ctors */
 #ifdef USE_EIGEN
@@ -57,6 +61,7 @@ public:
     Transform(JSON const& tx_json);
     Transform(Vector3f const& vec);
     Transform(elfin::Mat3f const& rot, Vector3f const& vec);
+    Transform(Floats const& floats);
 
     /* accessors */
     Vector3f collapsed() const;
@@ -83,6 +88,7 @@ public:
 
     JSON rot_json() const;
     JSON tran_json() const;
+    Floats to_floats() const;
 
     /* modifiers */
 #ifdef USE_EIGEN
@@ -10,11 +10,14 @@
 #include "ui_joint.h"
 #include "move_heap.h"
 #include "node_team.h"
+#include "collision.h"
+#include "scoring.h"
 
 namespace elfin {
 
 /* Fwd Decl */
 struct TestStat;
+class FitnessCache;
 
 /* types */
 #define FOREACH_WORKTYPE(MACRO) \
@@ -46,6 +49,8 @@ private:
 public:
     /* types */
     typedef std::unordered_map<UIJointKey, V3fList> PathMap;
+    typedef std::unordered_map<UIJointKey, std::vector<V3fList>> ResampledPathMap;
+    typedef std::unordered_map<UIJointKey, scoring::CenteredPath> CenteredPathMap;
     typedef std::unordered_map<std::string, UIJointKey> NamedJoints;
 
     /* data */
@@ -58,6 +63,9 @@ public:
     PathMap const           path_map;
     size_t const            path_len;
     size_t const            target_size;
+    ResampledPathMap const  resampled_path_map; // path_map upsampled to each size in (path_len, target_size + len_dev].
+    CenteredPathMap const   centered_path_map;  // path_map centered at its own size and each of resampled_path_map.
+    collision::SphereTree const fixed_modules;  // Modules of all fixed areas except this area's occupants.
 
     /* ctors */
     WorkArea(std::string const& _name,
@@ -69,6 +77,11 @@ public:
 
     /* accessors */
     TeamPtrMinHeap make_solution_minheap() const;
+    mutation::Stats const& mutation_stats() const;
+    // Scores of teams of this area, shared by all threads.
+    FitnessCache& fitness_cache() const;
+    // Path of ui_key upsampled to size if cached, otherwise the path as is.
+    V3fList const& ref_path(UIJointKey const ui_key, size_t const size) const;
 
     /* modifiers */
     void solve();
@@ -16,6 +16,41 @@ std::unordered_set<std::string> const RADIUS_TYPES = {
     "max_ca_dist"
 };
 
+std::unordered_set<std::string> const RMSD_ENGINES = {
+    "rosetta",
+    "qcp"
+};
+
+// generational: the whole population is replaced each generation.
+// steady_state: threads keep replacing the worst teams with children.
+std::unordered_set<std::string> const GA_MODES = {
+    "generational",
+    "steady_state"
+};
+
+// uniform: mutation modes are tried in random order with equal odds.
+// adaptive: modes that recently gained the most fitness per node touched
+// are more likely to be tried first.
+std::unordered_set<std::string> const MUTATION_SCHEDULES = {
+    "uniform",
+    "adaptive"
+};
+
+// none: teams are placed wherever their threads run.
+// local: the population is partitioned by NUMA node, and parents are mostly
+// drawn from the node of their child. Teams are assigned to nodes by rank, so
+// a seed repeats on machines with as many nodes.
+std::unordered_set<std::string> const NUMA_POLICIES = {
+    "none",
+    "local"
+};
+
+// ring: island i sends to island i + 1. all: every island sends to all others.
+std::unordered_set<std::string> const MIGRATION_TOPOLOGIES = {
+    "ring",
+    "all"
+};
+
 /* free functions */
 void arg_parse_failure(std::string const& arg_in,
                        ArgBundle const* argb) {
@@ -87,6 +122,12 @@ void ArgParser::check_options() const {
     PANIC_IF(options_.output_dir.empty(),
              BadArgument("No output directory given."));
 
+    PANIC_IF(options_.seed_solutions != "" and
+             not JUtil.file_exists(options_.seed_solutions.c_str()),
+             BadArgument("Seed solutions file \"" +
+                         options_.seed_solutions +
+                         "\" could not be found\n"));
+
     if (not JUtil.file_exists(options_.output_dir.c_str())) {
         JUtil.warn("Output directory does not exist; creating...\n");
         JUtil.mkdir_ifn_exists(options_.output_dir.c_str());
@@ -97,17 +138,36 @@ void ArgParser::check_options() const {
              options_.ga_survive_rate >= 1.0,
              BadArgument("GA survive rate must be between 0 and 1 exclusive.\n"));
 
+    PANIC_IF(options_.seed_rate < 0.0 or
+             options_.seed_rate > 1.0,
+             BadArgument("Seed rate must be between 0 and 1 inclusive.\n"));
+
+    PANIC_IF(options_.ga_islands == 0,
+             BadArgument("GA needs at least 1 island.\n"));
+
+    PANIC_IF(options_.ga_pop_size < 2 * options_.ga_islands,
+             BadArgument("GA population must have at least 2 teams per island.\n"));
+
+    PANIC_IF(options_.ga_mode == "steady_state" and options_.ga_islands != 1,
+             BadArgument("Steady state GA does not support islands.\n"));
+
+    PANIC_IF(options_.ga_mode == "steady_state" and
+             options_.ga_local_search_elites != 0,
+             BadArgument("Steady state GA does not support local search.\n"));
+
     PANIC_IF(options_.avg_pair_dist < 0,
              BadArgument("Average CoM distance must be > 0.\n"));
 }
 
-std::string ArgParser::radius_types_setting_string() const {
+std::string ArgParser::setting_string(
+    std::unordered_set<std::string> const& values) const
+{
     std::ostringstream oss;
     oss << "{ ";
     size_t count = 0;
-    for (auto& rt : RADIUS_TYPES) {
+    for (auto& rt : values) {
         oss << rt;
-        if (count++ < RADIUS_TYPES.size() - 1) {
+        if (count++ < values.size() - 1) {
             oss << ", ";
         }
     }
@@ -209,6 +269,16 @@ ARG_PARSER_CALLBACK_DEF(set_output_suffix) {
     return true;
 }
 
+ARG_PARSER_CALLBACK_DEF(set_seed_solutions) {
+    options_.seed_solutions = arg_in;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_seed_rate) {
+    options_.seed_rate = JUtil.parse_float(arg_in.c_str());
+    return true;
+}
+
 ARG_PARSER_CALLBACK_DEF(set_len_dev) {
     long const l = JUtil.parse_long(arg_in.c_str());
     options_.len_dev = l < 0 ? 0 : l;
@@ -230,6 +300,34 @@ ARG_PARSER_CALLBACK_DEF(set_seed) {
     return true;
 }
 
+ARG_PARSER_CALLBACK_DEF(set_ga_mode) {
+    bool const ga_mode_is_valid =
+        GA_MODES.find(arg_in) != end(GA_MODES);
+
+    if (ga_mode_is_valid) {
+        options_.ga_mode = arg_in;
+    }
+    else {
+        JUtil.error("Invalid GA mode: \"%s\"\n", arg_in.c_str());
+    }
+
+    return ga_mode_is_valid;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_ga_mutation_schedule) {
+    bool const schedule_is_valid =
+        MUTATION_SCHEDULES.find(arg_in) != end(MUTATION_SCHEDULES);
+
+    if (schedule_is_valid) {
+        options_.ga_mutation_schedule = arg_in;
+    }
+    else {
+        JUtil.error("Invalid mutation schedule: \"%s\"\n", arg_in.c_str());
+    }
+
+    return schedule_is_valid;
+}
+
 ARG_PARSER_CALLBACK_DEF(set_ga_pop_size) {
     long const l = JUtil.parse_long(arg_in.c_str());
     options_.ga_pop_size = l < 0 ? 0 : l;
@@ -266,6 +364,50 @@ ARG_PARSER_CALLBACK_DEF(set_ga_max_restarts) {
     return true;
 }
 
+ARG_PARSER_CALLBACK_DEF(set_ga_islands) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.ga_islands = l < 0 ? 0 : l;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_ga_migration_interval) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.ga_migration_interval = l < 0 ? 0 : l;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_ga_migration_size) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.ga_migration_size = l < 0 ? 0 : l;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_ga_migration_topology) {
+    bool const topology_is_valid =
+        MIGRATION_TOPOLOGIES.find(arg_in) != end(MIGRATION_TOPOLOGIES);
+
+    if (topology_is_valid) {
+        options_.ga_migration_topology = arg_in;
+    }
+    else {
+        JUtil.error("Invalid migration topology: \"%s\"\n", arg_in.c_str());
+    }
+
+    return topology_is_valid;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_ga_local_search_elites) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.ga_local_search_elites = l < 0 ? 0 : l;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_ga_local_search_budget) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.ga_local_search_budget = l < 0 ? 0 : l;
+    return true;
+}
+
 ARG_PARSER_CALLBACK_DEF(set_verbosity) {
     // Call jutil function to set global log level.
     long const l = JUtil.parse_long(arg_in.c_str());
@@ -290,12 +432,48 @@ ARG_PARSER_CALLBACK_DEF(set_n_workers) {
     return true;
 }
 
+ARG_PARSER_CALLBACK_DEF(set_pin_threads) {
+    options_.pin_threads = true;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_numa_policy) {
+    bool const numa_policy_is_valid =
+        NUMA_POLICIES.find(arg_in) != end(NUMA_POLICIES);
+
+    if (numa_policy_is_valid) {
+        options_.numa_policy = arg_in;
+    }
+    else {
+        JUtil.error("Invalid NUMA policy: \"%s\"\n", arg_in.c_str());
+    }
+
+    return numa_policy_is_valid;
+}
+
 ARG_PARSER_CALLBACK_DEF(set_keep_n) {
     long const l = JUtil.parse_long(arg_in.c_str());
     options_.keep_n = l < 0 ? 0 : l;
     return true;
 }
 
+ARG_PARSER_CALLBACK_DEF(set_fitness_cache_size) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.fitness_cache_size = l < 0 ? 0 : l;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_checkpoint_interval) {
+    long const l = JUtil.parse_long(arg_in.c_str());
+    options_.checkpoint_interval = l < 0 ? 0 : l;
+    return true;
+}
+
+ARG_PARSER_CALLBACK_DEF(set_resume) {
+    options_.resume = true;
+    return true;
+}
+
 ARG_PARSER_CALLBACK_DEF(set_dry_run) {
     options_.dry_run = true;
     return true;
@@ -320,6 +498,20 @@ ARG_PARSER_CALLBACK_DEF(set_radius_type) {
     return radiu_type_is_valid;
 }
 
+ARG_PARSER_CALLBACK_DEF(set_rmsd_engine) {
+    bool const rmsd_engine_is_valid =
+        RMSD_ENGINES.find(arg_in) != end(RMSD_ENGINES);
+
+    if (rmsd_engine_is_valid) {
+        options_.rmsd_engine = arg_in;
+    }
+    else {
+        JUtil.error("Invalid RMSD engine: \"%s\"\n", arg_in.c_str());
+    }
+
+    return rmsd_engine_is_valid;
+}
+
 /* printers */
 ARG_PARSER_CALLBACK_DEF(help_and_exit) {
     std::stringstream ss;
@@ -0,0 +1,147 @@
+#include "checkpoint.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "jutil.h"
+#include "debug_utils.h"
+#include "input_manager.h"
+#include "work_area.h"
+
+namespace elfin {
+
+namespace checkpoint {
+
+// Large enough that writes of single values rarely reach the disk on their
+// own.
+static size_t const BUFFER_BYTES = 1 << 20;
+
+/* Writer */
+/* protected */
+/* modifiers */
+void Writer::write(void const* const data, size_t const size) {
+    PANIC_IF(std::fwrite(data, 1, size, file_) != size,
+             BadArgument("Could not write checkpoint " + tmp_path_));
+}
+
+/* public */
+/* ctors */
+Writer::Writer(std::string const& path) :
+    path_(path),
+    tmp_path_(path + ".tmp")
+{
+    file_ = std::fopen(tmp_path_.c_str(), "wb");
+    PANIC_IF(not file_,
+             BadArgument("Could not open checkpoint " + tmp_path_));
+    std::setvbuf(file_, nullptr, _IOFBF, BUFFER_BYTES);
+}
+
+/* dtors */
+Writer::~Writer() {
+    if (file_) {
+        std::fclose(file_);
+        std::remove(tmp_path_.c_str());
+    }
+}
+
+/* modifiers */
+void Writer::put_string(std::string const& str) {
+    put<uint64_t>(str.size());
+    write(str.data(), str.size());
+}
+
+void Writer::commit() {
+    bool const synced = std::fflush(file_) == 0 and fsync(fileno(file_)) == 0;
+    bool const closed = std::fclose(file_) == 0;
+    file_ = nullptr;
+
+    // Rename is atomic, so readers see either the old or the new file.
+    PANIC_IF(not synced or not closed or
+             std::rename(tmp_path_.c_str(), path_.c_str()) != 0,
+             BadArgument("Could not save checkpoint " + path_));
+
+    // The rename is only durable once the directory entry is on disk.
+    size_t const last_slash_idx = path_.find_last_of('/');
+    std::string const dir = last_slash_idx == std::string::npos ?
+                            "." : path_.substr(0, last_slash_idx + 1);
+    int const dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    bool const dir_synced = dir_fd >= 0 and fsync(dir_fd) == 0;
+    if (dir_fd >= 0) {
+        close(dir_fd);
+    }
+    PANIC_IF(not dir_synced,
+             BadArgument("Could not save checkpoint directory " + dir));
+}
+
+/* Reader */
+/* protected */
+/* modifiers */
+void Reader::read(void* const data, size_t const size) {
+    PANIC_IF(std::fread(data, 1, size, file_) != size,
+             CouldNotParse("Checkpoint " + path_ + " ends early"));
+}
+
+uint64_t Reader::get_length(size_t const elem_size) {
+    uint64_t const length = get<uint64_t>();
+    long const pos = std::ftell(file_);
+    size_t const remaining = pos < 0 or size_ < (size_t) pos ?
+                             0 : size_ - pos;
+    PANIC_IF(elem_size > 0 and length > remaining / elem_size,
+             CouldNotParse("Checkpoint " + path_ + " has a length of " +
+                           std::to_string(length) + " past its end"));
+    return length;
+}
+
+/* public */
+/* ctors */
+Reader::Reader(std::string const& path) :
+    path_(path)
+{
+    file_ = std::fopen(path_.c_str(), "rb");
+    PANIC_IF(not file_,
+             BadArgument("Could not open checkpoint " + path_));
+    std::setvbuf(file_, nullptr, _IOFBF, BUFFER_BYTES);
+
+    // Lengths read later are checked against the size.
+    if (std::fseek(file_, 0, SEEK_END) == 0) {
+        long const size = std::ftell(file_);
+        size_ = size < 0 ? 0 : size;
+    }
+    std::rewind(file_);
+}
+
+/* dtors */
+Reader::~Reader() {
+    std::fclose(file_);
+}
+
+/* modifiers */
+std::string Reader::get_string() {
+    std::string res(get_length(sizeof(char)), '\0');
+    read(&res[0], res.size());
+    return res;
+}
+
+/* free functions */
+std::string path_of(WorkArea const& work_area) {
+    // Name after the spec file, without directory or extension.
+    std::string spec_name = OPTIONS.spec_file;
+    size_t const last_slash_idx = spec_name.find_last_of("\\/");
+    if (last_slash_idx != std::string::npos) {
+        spec_name.erase(0, last_slash_idx + 1);
+    }
+    size_t const period_idx = spec_name.rfind('.');
+    if (period_idx != std::string::npos) {
+        spec_name.erase(period_idx);
+    }
+
+    return OPTIONS.output_dir + "/" + spec_name + "_" + work_area.name + ".ckpt";
+}
+
+bool exists(WorkArea const& work_area) {
+    return JUtil.file_exists(path_of(work_area).c_str());
+}
+
+}  /* checkpoint */
+
+}  /* elfin */
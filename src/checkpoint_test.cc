@@ -0,0 +1,208 @@
+#include "checkpoint.h"
+
+#include "test_data.h"
+#include "test_stat.h"
+#include "input_manager.h"
+#include "hinge_team.h"
+#include "node_pool.h"
+
+namespace elfin {
+
+namespace checkpoint {
+
+/* tests */
+TestStat test() {
+    TestStat ts;
+
+    JUtil.mkdir_ifn_exists(OPTIONS.output_dir.c_str());
+    std::string const path = OPTIONS.output_dir + "/checkpoint_test.ckpt";
+
+    // Values come back in the order they were written.
+    {
+        {
+            Writer writer(path);
+            writer.put<uint32_t>(0xbeef1337);
+            writer.put(1.5f);
+            writer.put_string("elfin");
+            writer.put_vector<uint64_t>({3, 1, 4});
+            writer.commit();
+        }
+
+        Reader reader(path);
+        bool const ok = reader.get<uint32_t>() == 0xbeef1337 and
+                        reader.get<float>() == 1.5f and
+                        reader.get_string() == "elfin" and
+                        reader.get_vector<uint64_t>() ==
+                        std::vector<uint64_t>({3, 1, 4});
+
+        ts.tests++;
+        if (not ok) {
+            ts.errors++;
+            JUtil.error("Checkpoint values did not read back as written\n");
+        }
+
+        // Reading past the end fails loudly.
+        ts.tests++;
+        try {
+            reader.get<uint64_t>();
+            ts.errors++;
+            JUtil.error("Checkpoint read past its end\n");
+        }
+        catch (CouldNotParse const& e) {}
+    }
+
+    // A checkpoint that is not committed leaves the last one in place.
+    {
+        {
+            Writer writer(path);
+            writer.put<uint32_t>(0);
+        }
+
+        ts.tests++;
+        Reader reader(path);
+        if (reader.get<uint32_t>() != 0xbeef1337) {
+            ts.errors++;
+            JUtil.error("Uncommitted checkpoint replaced the last one\n");
+        }
+    }
+
+    // Lengths past the end of a corrupt checkpoint fail before anything is
+    // allocated for them.
+    {
+        {
+            Writer writer(path);
+            writer.put<uint64_t>(UINT64_MAX / 2);
+            writer.put<uint64_t>(3);
+            writer.put<uint64_t>(1);
+            writer.commit();
+        }
+
+        ts.tests++;
+        try {
+            Reader(path).get_string();
+            ts.errors++;
+            JUtil.error("Checkpoint string length went unchecked\n");
+        }
+        catch (CouldNotParse const& e) {}
+
+        // Three elements are claimed but only one follows.
+        ts.tests++;
+        try {
+            Reader reader(path);
+            reader.get<uint64_t>();
+            reader.get_vector<uint64_t>();
+            ts.errors++;
+            JUtil.error("Checkpoint vector length went unchecked\n");
+        }
+        catch (CouldNotParse const& e) {}
+    }
+
+    // A node pool whose free slots are out of range, repeated or in use is
+    // rejected, as is one whose slot count runs past the end.
+    {
+        auto const pool_test =
+        [&](std::vector<uint64_t> const& free_slots, char const* what) {
+            {
+                Writer writer(path);
+                writer.put<uint64_t>(2);
+                writer.put<uint8_t>(false);
+                writer.put<uint8_t>(false);
+                writer.put_vector(free_slots);
+                writer.commit();
+            }
+
+            ts.tests++;
+            try {
+                Reader reader(path);
+                NodePool().read_checkpoint(reader);
+                ts.errors++;
+                JUtil.error("Checkpoint node pool with %s went unchecked\n",
+                            what);
+            }
+            catch (CouldNotParse const& e) {}
+        };
+
+        pool_test({2}, "a free slot out of range");
+        pool_test({1, 1}, "a repeated free slot");
+
+        {
+            Writer writer(path);
+            writer.put<uint64_t>(UINT64_MAX / 2);
+            writer.commit();
+        }
+
+        ts.tests++;
+        try {
+            Reader reader(path);
+            NodePool().read_checkpoint(reader);
+            ts.errors++;
+            JUtil.error("Checkpoint node pool size went unchecked\n");
+        }
+        catch (CouldNotParse const& e) {}
+    }
+
+    // A restored team has the same nodes and scores, and evolves into the
+    // same child as the team it was saved from.
+    auto const team_test =
+    [&](std::string const& spec_file, tests::Recipe const& recipe) {
+        InputManager::setup_test({"--spec_file", spec_file});
+        Spec const spec(OPTIONS);
+        auto const wa = (*begin(spec.work_packages()))->work_area_keys().at(0);
+
+        auto team = NodeTeam::create_team(wa, OPTIONS.seed);
+        Transform const shift_tx = wa->type == WorkType::FREE ?
+                                   Transform() :
+                                   begin(wa->occupied_joints)->second->
+                                   occupant.ui_module->tx;
+        static_cast<PathTeam&>(*team).implement_recipe(recipe, shift_tx);
+
+        {
+            Writer writer(path);
+            team->write_checkpoint(writer);
+            writer.commit();
+        }
+
+        auto restored = NodeTeam::create_team(wa, 0);
+        {
+            Reader reader(path);
+            restored->read_checkpoint(reader);
+        }
+
+        ts.tests++;
+        if (restored->to_json() != team->to_json() or
+                restored->score() != team->score() or
+                restored->checksum() != team->checksum() or
+                restored->seed_ != team->seed_ or
+                restored->size() != team->size()) {
+            ts.errors++;
+            JUtil.error("Team of %s did not restore from checkpoint\n",
+                        spec_file.c_str());
+            return;
+        }
+
+        mutation::Scheduler const scheduler(/*adaptive=*/ false);
+        mutation::Record record;
+
+        auto child = team->clone();
+        child->evolve(*team, *team, scheduler, record);
+        auto restored_child = restored->clone();
+        restored_child->evolve(*restored, *restored, scheduler, record);
+
+        ts.tests++;
+        if (restored_child->to_json() != child->to_json()) {
+            ts.errors++;
+            JUtil.error("Team of %s evolved differently after restoring "
+                        "from checkpoint\n", spec_file.c_str());
+        }
+    };
+
+    team_test("examples/quarter_snake_free.json",
+              tests::QUARTER_SNAKE_FREE_RECIPE);
+    team_test("examples/H_1h.json", tests::H_1H_RECIPE);
+
+    return ts;
+}
+
+}  /* checkpoint */
+
+}  /* elfin */
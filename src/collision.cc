@@ -0,0 +1,292 @@
+#include "collision.h"
+
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+namespace elfin {
+
+namespace collision {
+
+// Below this many spheres the all-pairs check is cheaper than the hash.
+static size_t const MAX_ALL_PAIRS_SIZE = 48;
+
+// SphereTree nodes with at most this many spheres are not split further.
+static uint32_t const MAX_LEAF_SIZE = 4;
+
+/* Spheres */
+void Spheres::clear() {
+    xs_.clear();
+    ys_.clear();
+    zs_.clear();
+    sq_radii_.clear();
+    max_radius_ = 0;
+}
+
+void Spheres::push_back(Vector3f const& center, float const radius) {
+    xs_.push_back(center[0]);
+    ys_.push_back(center[1]);
+    zs_.push_back(center[2]);
+    sq_radii_.push_back(radius * radius);
+    max_radius_ = std::max(max_radius_, radius);
+}
+
+bool overlap(Spheres const& spheres, size_t const i, size_t const j) {
+    float const dx = spheres.xs()[i] - spheres.xs()[j];
+    float const dy = spheres.ys()[i] - spheres.ys()[j];
+    float const dz = spheres.zs()[i] - spheres.zs()[j];
+    return dx * dx + dy * dy + dz * dz <
+           std::max(spheres.sq_radii()[i], spheres.sq_radii()[j]);
+}
+
+// Compares each sphere with all spheres before it, one vectorized row at a
+// time.
+bool any_overlap_all_pairs(Spheres const& spheres) {
+    float const* const xs = spheres.xs();
+    float const* const ys = spheres.ys();
+    float const* const zs = spheres.zs();
+    float const* const sq_radii = spheres.sq_radii();
+
+    for (size_t i = 1; i < spheres.size(); ++i) {
+        int hit = 0;
+        #pragma omp simd reduction(|:hit)
+        for (size_t j = 0; j < i; ++j) {
+            float const dx = xs[i] - xs[j];
+            float const dy = ys[i] - ys[j];
+            float const dz = zs[i] - zs[j];
+            hit |= dx * dx + dy * dy + dz * dz <
+                   std::max(sq_radii[i], sq_radii[j]);
+        }
+
+        if (hit) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Inserts spheres one by one into a hash of grid cells, checking each against
+// the spheres already inserted in the 27 cells around it. Overlapping centers
+// are less than max_radius() apart, so they are at most one cell apart on
+// every axis.
+bool any_overlap_hashed(Spheres const& spheres) {
+    size_t const n = spheres.size();
+    float const cell_width = spheres.max_radius();
+    if (not (cell_width > 0)) {
+        return false;
+    }
+
+    // Power of two bucket count at least twice the sphere count.
+    size_t n_buckets = 1;
+    while (n_buckets < 2 * n) {
+        n_buckets <<= 1;
+    }
+    size_t const mask = n_buckets - 1;
+
+    auto const bucket_of = [mask](int64_t const x,
+                                  int64_t const y,
+                                  int64_t const z) {
+        return static_cast<size_t>((x * 73856093) ^
+                                   (y * 19349663) ^
+                                   (z * 83492791)) & mask;
+    };
+
+    // Each bucket heads a list of sphere ids threaded through next.
+    thread_local std::vector<int64_t> cells;
+    thread_local std::vector<long> heads, next;
+    cells.resize(3 * n);
+    heads.assign(n_buckets, -1);
+    next.resize(n);
+
+    for (size_t i = 0; i < n; ++i) {
+        int64_t const cx = std::floor(spheres.xs()[i] / cell_width);
+        int64_t const cy = std::floor(spheres.ys()[i] / cell_width);
+        int64_t const cz = std::floor(spheres.zs()[i] / cell_width);
+
+        for (int64_t x = cx - 1; x <= cx + 1; ++x) {
+            for (int64_t y = cy - 1; y <= cy + 1; ++y) {
+                for (int64_t z = cz - 1; z <= cz + 1; ++z) {
+                    for (long j = heads[bucket_of(x, y, z)];
+                            j != -1;
+                            j = next[j]) {
+                        // Skip spheres of other cells sharing the bucket, so
+                        // that no pair is visited twice.
+                        if (cells[3 * j] != x or
+                                cells[3 * j + 1] != y or
+                                cells[3 * j + 2] != z) {
+                            continue;
+                        }
+
+                        if (overlap(spheres, i, j)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+
+        cells[3 * i] = cx;
+        cells[3 * i + 1] = cy;
+        cells[3 * i + 2] = cz;
+        size_t const bucket = bucket_of(cx, cy, cz);
+        next[i] = heads[bucket];
+        heads[bucket] = i;
+    }
+
+    return false;
+}
+
+bool any_overlap(Spheres const& spheres) {
+    if (spheres.size() <= MAX_ALL_PAIRS_SIZE) {
+        return any_overlap_all_pairs(spheres);
+    }
+
+    return any_overlap_hashed(spheres);
+}
+
+/* SphereTree */
+SphereTree::SphereTree(Spheres const& spheres) {
+    size_t const n = spheres.size();
+    if (n == 0) {
+        return;
+    }
+
+    std::vector<uint32_t> ids(n);
+    std::iota(begin(ids), end(ids), 0);
+    nodes_.reserve(2 * n / MAX_LEAF_SIZE + 1);
+    build(ids, 0, n, spheres);
+
+    for (auto const id : ids) {
+        spheres_.push_back(
+            Vector3f(spheres.xs()[id], spheres.ys()[id], spheres.zs()[id]),
+            sqrt(spheres.sq_radii()[id]));
+    }
+}
+
+bool SphereTree::overlaps(float const x,
+                          float const y,
+                          float const z,
+                          float const sq_radius) const
+{
+    if (nodes_.empty()) {
+        return false;
+    }
+
+    // Depth is logarithmic in size() because nodes are split at the median.
+    uint32_t stack[64];
+    size_t depth = 0;
+    stack[depth++] = 0;
+
+    float const point[3] = {x, y, z};
+    while (depth) {
+        Node const& node = nodes_[stack[--depth]];
+
+        // No center in the node can be within reach if the box is not.
+        float sq_dist = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            float const d = std::max({node.lo[i] - point[i],
+                                      point[i] - node.hi[i],
+                                      0.0f});
+            sq_dist += d * d;
+        }
+
+        float const max_radius = node.max_radius;
+        if (sq_dist >= std::max(max_radius * max_radius, sq_radius)) {
+            continue;
+        }
+
+        if (node.right == 0) {
+            for (uint32_t i = node.begin; i < node.end; ++i) {
+                float const dx = spheres_.xs()[i] - x;
+                float const dy = spheres_.ys()[i] - y;
+                float const dz = spheres_.zs()[i] - z;
+                if (dx * dx + dy * dy + dz * dz <
+                        std::max(spheres_.sq_radii()[i], sq_radius)) {
+                    return true;
+                }
+            }
+        }
+        else {
+            stack[depth++] = node.right;
+            stack[depth++] = (&node - nodes_.data()) + 1;
+        }
+    }
+
+    return false;
+}
+
+bool SphereTree::overlaps(Vector3f const& center, float const radius) const {
+    return overlaps(center[0], center[1], center[2], radius * radius);
+}
+
+bool SphereTree::overlaps_any(Spheres const& spheres) const {
+    for (size_t i = 0; i < spheres.size(); ++i) {
+        if (overlaps(spheres.xs()[i],
+                     spheres.ys()[i],
+                     spheres.zs()[i],
+                     spheres.sq_radii()[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SphereTree::build(std::vector<uint32_t>& ids,
+                       uint32_t const begin,
+                       uint32_t const end,
+                       Spheres const& spheres)
+{
+    float const* const coords[3] = {spheres.xs(), spheres.ys(), spheres.zs()};
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.max_radius = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        node.lo[i] = INFINITY;
+        node.hi[i] = -INFINITY;
+    }
+
+    for (uint32_t k = begin; k < end; ++k) {
+        uint32_t const id = ids[k];
+        for (size_t i = 0; i < 3; ++i) {
+            node.lo[i] = std::min(node.lo[i], coords[i][id]);
+            node.hi[i] = std::max(node.hi[i], coords[i][id]);
+        }
+        node.max_radius = std::max(node.max_radius,
+                                   sqrt(spheres.sq_radii()[id]));
+    }
+
+    size_t const node_id = nodes_.size();
+    nodes_.push_back(node);
+
+    if (end - begin > MAX_LEAF_SIZE) {
+        // Split at the median along the widest axis.
+        size_t axis = 0;
+        for (size_t i = 1; i < 3; ++i) {
+            if (node.hi[i] - node.lo[i] > node.hi[axis] - node.lo[axis]) {
+                axis = i;
+            }
+        }
+
+        uint32_t const mid = begin + (end - begin) / 2;
+        float const* const axis_coords = coords[axis];
+        std::nth_element(
+            ids.begin() + begin,
+            ids.begin() + mid,
+            ids.begin() + end,
+        [axis_coords](uint32_t const a, uint32_t const b) {
+            return axis_coords[a] < axis_coords[b];
+        });
+
+        build(ids, begin, mid, spheres);
+        nodes_[node_id].right = nodes_.size();
+        build(ids, mid, end, spheres);
+    }
+}
+
+}  /* collision */
+
+}  /* elfin */
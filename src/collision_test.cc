@@ -0,0 +1,125 @@
+#include "collision.h"
+
+#include "test_stat.h"
+#include "random_utils.h"
+
+namespace elfin {
+
+namespace collision {
+
+/* tests */
+TestStat test() {
+    TestStat ts;
+
+    // Reference: the all-pairs loop that compares every ordered pair.
+    auto const brute_force = [](Spheres const& spheres) {
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            for (size_t j = 0; j < spheres.size(); ++j) {
+                if (i == j) continue;
+
+                float const dx = spheres.xs()[i] - spheres.xs()[j];
+                float const dy = spheres.ys()[i] - spheres.ys()[j];
+                float const dz = spheres.zs()[i] - spheres.zs()[j];
+                if (dx * dx + dy * dy + dz * dz <
+                        std::max(spheres.sq_radii()[i], spheres.sq_radii()[j])) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    // Random chains of spheres, on both sides of the all-pairs size limit
+    // and with both negative and positive coordinates.
+    random::Stream seed(0xc011);
+    size_t n_colliding = 0;
+    for (size_t const n : {0, 1, 2, 10, 47, 48, 49, 100, 300}) {
+        for (size_t trial = 0; trial < 20; ++trial) {
+            ts.tests++;
+
+            Spheres spheres;
+            Vector3f center(-100, -100, -100);
+            for (size_t i = 0; i < n; ++i) {
+                spheres.push_back(
+                    center,
+                    5 + 10 * random::get_dice_0to1(seed));
+                center += Vector3f(
+                              20 * random::get_dice_0to1(seed) - 6,
+                              20 * random::get_dice_0to1(seed) - 6,
+                              20 * random::get_dice_0to1(seed) - 6);
+            }
+
+            bool const expected = brute_force(spheres);
+            n_colliding += expected;
+            if (any_overlap(spheres) != expected) {
+                ts.errors++;
+                JUtil.error("Collision test failed for %zu spheres "
+                            "(trial %zu). Expected %s\n",
+                            n, trial, expected ? "overlap" : "no overlap");
+            }
+        }
+    }
+
+    // Make sure both outcomes were covered.
+    ts.tests++;
+    if (n_colliding == 0 or n_colliding == 9 * 20) {
+        ts.errors++;
+        JUtil.error("Collision test data only had %zu colliding cases\n",
+                    n_colliding);
+    }
+
+    // SphereTree against a brute force scan of the same spheres.
+    for (size_t const n : {0, 1, 4, 5, 50, 500}) {
+        Spheres fixed;
+        for (size_t i = 0; i < n; ++i) {
+            fixed.push_back(
+                Vector3f(400 * random::get_dice_0to1(seed) - 200,
+                         400 * random::get_dice_0to1(seed) - 200,
+                         400 * random::get_dice_0to1(seed) - 200),
+                5 + 10 * random::get_dice_0to1(seed));
+        }
+
+        SphereTree const tree(fixed);
+        size_t n_hits = 0;
+        for (size_t trial = 0; trial < 200; ++trial) {
+            ts.tests++;
+
+            Vector3f const center(400 * random::get_dice_0to1(seed) - 200,
+                                  400 * random::get_dice_0to1(seed) - 200,
+                                  400 * random::get_dice_0to1(seed) - 200);
+            float const radius = 20 * random::get_dice_0to1(seed);
+
+            bool expected = false;
+            for (size_t i = 0; i < n; ++i) {
+                float const dx = fixed.xs()[i] - center[0];
+                float const dy = fixed.ys()[i] - center[1];
+                float const dz = fixed.zs()[i] - center[2];
+                expected |= dx * dx + dy * dy + dz * dz <
+                            std::max(fixed.sq_radii()[i], radius * radius);
+            }
+
+            n_hits += expected;
+            if (tree.overlaps(center, radius) != expected) {
+                ts.errors++;
+                JUtil.error("SphereTree test failed for %zu spheres "
+                            "(trial %zu). Expected %s\n",
+                            n, trial, expected ? "overlap" : "no overlap");
+            }
+        }
+
+        if (n == 500) {
+            ts.tests++;
+            if (n_hits == 0 or n_hits == 200) {
+                ts.errors++;
+                JUtil.error("SphereTree test data only had %zu hits\n",
+                            n_hits);
+            }
+        }
+    }
+
+    return ts;
+}
+
+}  /* collision */
+
+}  /* elfin */
@@ -77,6 +77,10 @@ void Database::categorize() {
             PANIC(BadXDB(msg));
         }
     }
+
+    for (auto roulette : {&singles_, &hubs_, &basic_mods_, &complex_mods_}) {
+        roulette->build_alias_table();
+    }
 }
 
 void Database::print_roulettes() {
@@ -140,7 +140,7 @@ void DoubleHingeTeam::virtual_implement_recipe(
 /* public */
 /* ctors */
 DoubleHingeTeam::DoubleHingeTeam(WorkArea const* const wa,
-                                 uint32_t const seed) :
+                                 random::Stream const& seed) :
     HingeTeam(wa, seed),
     pimpl_(new_pimpl<PImpl>(*this))
 {
@@ -174,4 +174,21 @@ DoubleHingeTeam& DoubleHingeTeam::operator=(DoubleHingeTeam && other) {
     return *this;
 }
 
+void DoubleHingeTeam::read_checkpoint(checkpoint::Reader& reader) {
+    // The second hinge follows from the first.
+    HingeTeam::read_checkpoint(reader);
+    pimpl_->find_hinge2();
+}
+
+bool DoubleHingeTeam::prepare_score() {
+    // Same as evaluate(): complete the path before it can be scored.
+    if (pimpl_->complete_path()) {
+        return HingeTeam::prepare_score();
+    }
+    else {
+        score_ = INFINITY;
+        return false;
+    }
+}
+
 }  /* elfin */
\ No newline at end of file
@@ -8,11 +8,18 @@
 #include "jutil.h"
 #include "input_manager.h"
 #include "parallel_utils.h"
+#include "fitness_cache.h"
+#include "checkpoint.h"
+#include "random_utils.h"
+#include "solution_archive.h"
 
 namespace elfin {
 
 /* private */
 struct EvolutionSolver::PImpl {
+    /* types */
+    typedef std::vector<std::unique_ptr<Population>> Islands;
+
     /* data */
     bool score_satisfied_;
     bool should_restart_ga_;
@@ -24,6 +31,7 @@ struct EvolutionSolver::PImpl {
     size_t gen_id;
     double tot_gen_time;
     size_t stagnant_count;
+    mutation::Stats mutation_stats_;
 
     /* ctors */
     PImpl(size_t const debug_pop_print_n) :
@@ -42,15 +50,28 @@ struct EvolutionSolver::PImpl {
         gen_id = 0;
         tot_gen_time = 0.0f;
         stagnant_count = 0;
+        mutation_stats_ = mutation::Stats();
     }
 
-    void summarize_generation(Population const& pop,
+    void summarize_generation(WorkArea const& wa,
+                              Islands const& islands,
                               double const gen_start_time,
-                              TeamSPMaxHeap& output)
+                              SolutionArchive& archive)
     {
         // Stat collection
-        auto const& best_team = pop.front_buffer()->front();
-        auto const& worst_team = pop.front_buffer()->back();
+        NodeTeam const* best_team = nullptr;
+        NodeTeam const* worst_team = nullptr;
+        for (auto const& island : islands) {
+            auto const& teams = *island->front_buffer();
+            if (not best_team or
+                    teams.front()->score() < best_team->score()) {
+                best_team = teams.front().get();
+            }
+            if (not worst_team or
+                    teams.back()->score() > worst_team->score()) {
+                worst_team = teams.back().get();
+            }
+        }
 
         float const best_score = best_team->score();
         Crc32 const& best_checksum = best_team->checksum();
@@ -81,47 +102,32 @@ struct EvolutionSolver::PImpl {
 
         last_best_checksum_ = best_checksum;
 
-        // Print timing stats.
+        // Print timing stats. Islands run side by side and each adds its
+        // own phase times, so those are averaged over islands too.
         size_t const n_gens = gen_id + 1;
+        double const n_island_gens =
+            n_gens * std::max((size_t) 1, islands.size());
         JUtil.info("Avg Times: "
-                   "[Evolve=%.0f, Score=%.0f, Rank=%.0f, "
-                   "Select=%.0f, Gen=%.0f]\n",
-                   (double) GA_TIMES.evolve_time / n_gens,
-                   (double) GA_TIMES.score_time / n_gens,
-                   (double) GA_TIMES.rank_time / n_gens,
-                   (double) GA_TIMES.select_time / n_gens,
+                   "[Evolve=%.0f (Idle=%.0f), Score=%.0f, Rank=%.0f, "
+                   "Select=%.0f, Refine=%.0f, Gen=%.0f]\n",
+                   GA_TIMES.evolve_time / n_island_gens,
+                   GA_TIMES.evolve_idle_time / n_island_gens,
+                   GA_TIMES.score_time / n_island_gens,
+                   GA_TIMES.rank_time / n_island_gens,
+                   GA_TIMES.select_time / n_island_gens,
+                   GA_TIMES.refine_time / n_island_gens,
                    (double) tot_gen_time / n_gens);
+        print_cache_stats(wa);
 
         // Update best solutions.
-        size_t const max_keep = std::min(OPTIONS.keep_n, OPTIONS.ga_pop_size);
-        for (auto const& team : *pop.front_buffer()) {
-            if (output.empty() or team->score() < output.top()->score()) {
-                // Make sure checksum doesn't equal any existing solution.
-                bool checksum_repeat = false;
-                TeamSPMaxHeap output_tmp;
-                while (!output.empty()) {
-                    auto const& existing_team = output.top();
-                    checksum_repeat |= existing_team->checksum() == team->checksum();
-                    output_tmp.push(std::move(output.top_and_pop()));
-                }
-
-                while (!output_tmp.empty()) {
-                    output.push(std::move(output_tmp.top_and_pop()));
-                }
-
-                if (checksum_repeat)
-                    continue;
-
-                auto team_clone = team->clone();
-                output.push(std::move(team_clone));
-            }
-            else {
-                break;
-            }
-
-            while (output.size() > max_keep)
-                output.pop();
+        std::vector<SolutionArchive::Candidates> candidate_lists(
+            islands.size());
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < islands.size(); ++i) {
+            candidate_lists[i] =
+                archive.candidates(*islands.at(i)->front_buffer());
         }
+        archive.merge(candidate_lists);
 
         // Check stop conditions.
         if (best_score <= OPTIONS.ga_stop_score) {
@@ -156,6 +162,144 @@ struct EvolutionSolver::PImpl {
         }
     }
 
+    /* checkpoints */
+    // A checkpoint is only resumed under the options that shaped it.
+    void write_settings(checkpoint::Writer& writer,
+                        WorkArea const& wa) const {
+        writer.put_string("elfin-checkpoint");
+        writer.put(checkpoint::VERSION);
+        writer.put_string(wa.name);
+        writer.put(OPTIONS.seed);
+        writer.put<uint64_t>(OPTIONS.ga_pop_size);
+        writer.put(OPTIONS.ga_survive_rate);
+        writer.put<uint64_t>(OPTIONS.ga_islands);
+        writer.put_string(OPTIONS.ga_mode);
+        writer.put_string(OPTIONS.ga_mutation_schedule);
+        writer.put<uint64_t>(OPTIONS.ga_migration_interval);
+        writer.put<uint64_t>(OPTIONS.ga_migration_size);
+        writer.put_string(OPTIONS.ga_migration_topology);
+        writer.put<uint64_t>(OPTIONS.ga_local_search_elites);
+        writer.put<uint64_t>(OPTIONS.ga_local_search_budget);
+        writer.put(OPTIONS.collision_penalty);
+        writer.put_string(OPTIONS.numa_policy);
+        writer.put<uint64_t>(XDB.all_mods().size());
+    }
+
+    void check_settings(checkpoint::Reader& reader,
+                        WorkArea const& wa) const {
+        std::string const path = checkpoint::path_of(wa);
+        PANIC_IF(reader.get_string() != "elfin-checkpoint" or
+                 reader.get<uint32_t>() != checkpoint::VERSION,
+                 CouldNotParse(path + " is not a checkpoint of this version"));
+
+        bool const same_settings =
+            reader.get_string() == wa.name and
+            reader.get<uint32_t>() == OPTIONS.seed and
+            reader.get<uint64_t>() == OPTIONS.ga_pop_size and
+            reader.get<float>() == OPTIONS.ga_survive_rate and
+            reader.get<uint64_t>() == OPTIONS.ga_islands and
+            reader.get_string() == OPTIONS.ga_mode and
+            reader.get_string() == OPTIONS.ga_mutation_schedule and
+            reader.get<uint64_t>() == OPTIONS.ga_migration_interval and
+            reader.get<uint64_t>() == OPTIONS.ga_migration_size and
+            reader.get_string() == OPTIONS.ga_migration_topology and
+            reader.get<uint64_t>() == OPTIONS.ga_local_search_elites and
+            reader.get<uint64_t>() == OPTIONS.ga_local_search_budget and
+            reader.get<float>() == OPTIONS.collision_penalty and
+            reader.get_string() == OPTIONS.numa_policy and
+            reader.get<uint64_t>() == XDB.all_mods().size();
+        PANIC_IF(not same_settings,
+                 BadArgument(path + " was made with other GA options "
+                             "or another database"));
+    }
+
+    // Saves the state between two generations. Without islands, the work
+    // area is marked as solved.
+    void save_checkpoint(WorkArea const& wa,
+                         Islands const& islands,
+                         TeamSPMaxHeap const& output) const {
+        double const start_time = JUtil.get_timestamp_us();
+
+        checkpoint::Writer writer(checkpoint::path_of(wa));
+        write_settings(writer, wa);
+
+        writer.put<uint64_t>(restart_id);
+        writer.put<uint64_t>(gen_id);
+        writer.put<uint64_t>(itr_id);
+        writer.put<uint64_t>(stagnant_count);
+        writer.put(last_best_checksum_);
+        writer.put(tot_gen_time);
+        writer.put(mutation_stats_);
+
+        // The heap is kept as laid out so that ties come out the same.
+        writer.put<uint64_t>(output.container().size());
+        for (auto const& team : output.container()) {
+            team->write_checkpoint(writer);
+        }
+
+        writer.put<uint64_t>(islands.size());
+        for (auto const& island : islands) {
+            island->write_checkpoint(writer);
+        }
+
+        writer.commit();
+
+        JUtil.info("Saved checkpoint %s in %.0fms\n",
+                   checkpoint::path_of(wa).c_str(),
+                   (JUtil.get_timestamp_us() - start_time) / 1e3);
+    }
+
+    // Returns false if the work area was already solved. Otherwise islands
+    // are filled in to continue with.
+    bool load_checkpoint(WorkArea const& wa,
+                         Islands& islands,
+                         TeamSPMaxHeap& output) {
+        checkpoint::Reader reader(checkpoint::path_of(wa));
+        check_settings(reader, wa);
+
+        restart_id = reader.get<uint64_t>();
+        gen_id = reader.get<uint64_t>();
+        itr_id = reader.get<uint64_t>();
+        stagnant_count = reader.get<uint64_t>();
+        last_best_checksum_ = reader.get<Crc32>();
+        tot_gen_time = reader.get<double>();
+        mutation_stats_ = reader.get<mutation::Stats>();
+
+        // Each team takes at least its home node, and the archive never
+        // keeps more teams than a population has.
+        std::string const path = checkpoint::path_of(wa);
+        size_t const n_output = reader.get_length(sizeof(uint64_t));
+        PANIC_IF(n_output > OPTIONS.ga_pop_size,
+                 CouldNotParse(path + " has too many output teams"));
+        std::vector<NodeTeamSP> output_teams(n_output);
+        for (auto& team : output_teams) {
+            team = NodeTeam::create_team(&wa, 0);
+            team->read_checkpoint(reader);
+        }
+        output.assign(std::move(output_teams));
+
+        size_t const n_islands = reader.get<uint64_t>();
+        PANIC_IF(n_islands > OPTIONS.ga_islands,
+                 CouldNotParse(path + " has too many islands"));
+        for (size_t i = 0; i < n_islands; ++i) {
+            islands.push_back(std::make_unique<Population>(
+                                  &wa, reader, island_cutoffs()));
+        }
+
+        JUtil.info("Resumed %s at restart #%zu generation #%zu\n",
+                   wa.name.c_str(), restart_id, gen_id);
+        return n_islands > 0;
+    }
+
+    /* accessors */
+    Cutoffs island_cutoffs() const {
+        // A single island is the whole population.
+        size_t const n_islands = OPTIONS.ga_islands;
+        return n_islands == 1 ?
+               CUTOFFS :
+               calc_cutoffs(OPTIONS.ga_pop_size / n_islands);
+    }
+
     /* printers */
     void print_start_msg(WorkArea const& wa) const
     {
@@ -165,6 +309,12 @@ struct EvolutionSolver::PImpl {
         JUtil.info("Using deviation allowance: %d nodes\n", OPTIONS.len_dev);
         JUtil.info("Max Iterations: %zu\n", OPTIONS.ga_max_iters);
         JUtil.info("Surviors: %u\n", CUTOFFS.survivors);
+        JUtil.info("GA mode: %s\n", OPTIONS.ga_mode.c_str());
+        if (OPTIONS.ga_islands > 1) {
+            JUtil.info("Islands: %zu; migrating every %zu generations\n",
+                       OPTIONS.ga_islands,
+                       OPTIONS.ga_migration_interval);
+        }
 
         JUtil.info("There are %d devices. Host ID=%d; currently using ID=%d\n",
                    omp_get_num_devices(), omp_get_initial_device(), OPTIONS.device);
@@ -179,7 +329,21 @@ struct EvolutionSolver::PImpl {
         }
     }
 
-    void print_end_msg() const {
+    void print_cache_stats(WorkArea const& wa) const {
+        auto const& cache = wa.fitness_cache();
+        if (cache.enabled()) {
+            auto const stats = cache.stats();
+            JUtil.info("Fitness cache: %.1f%% hits (%zu of %zu lookups), "
+                       "%zu evictions, %zu entries max\n",
+                       100.f * stats.hit_rate(),
+                       stats.hits,
+                       stats.hits + stats.misses,
+                       stats.evictions,
+                       cache.capacity());
+        }
+    }
+
+    void print_end_msg(WorkArea const& wa) const {
         if (restart_id != 0 and restart_id == OPTIONS.ga_max_restarts) {
             JUtil.warn("Reached max restarts (%zu)\n", OPTIONS.ga_max_restarts);
         }
@@ -192,6 +356,10 @@ struct EvolutionSolver::PImpl {
         size_t const milliseconds = std::floor(fmod(time_elapsed_in_us / 1e3, 1000.0f));
         JUtil.info("EvolutionSolver finished in %zum %zus %zums\n",
                    minutes, seconds, milliseconds);
+        print_cache_stats(wa);
+
+        JUtil.debug("Mutation stats: %s\n",
+                    mutation_stats_.to_json().dump().c_str());
     }
 
 
@@ -217,7 +385,10 @@ struct EvolutionSolver::PImpl {
                                      c->score());
             }
 
-            for (size_t i = 0; i < max_n; ++i) {
+            // A steady state population has no back buffer.
+            size_t const max_back_n =
+                std::min(max_n, pop.back_buffer()->size());
+            for (size_t i = 0; i < max_back_n; ++i) {
                 auto& c = pop.back_buffer()->at(i);
                 oss << string_format(PRINT_POP_FMT,
                                      "  back ",
@@ -232,59 +403,195 @@ struct EvolutionSolver::PImpl {
     }
 #undef PRINT_POP_FMT
 
+    void run_generation(Population& population, bool const print) {
+        population.evolve();
+        population.score();
+        if (print) print_pop("After evolve", population);
+
+        population.rank();
+        if (print) print_pop("Post rank", population);
+
+        population.select();
+        if (print) print_pop("Post select", population);
+
+        population.refine();
+        if (print and OPTIONS.ga_local_search_elites) {
+            print_pop("Post refine", population);
+        }
+    }
+
+    // Sends clones of each island's best survivors to its neighbours. All
+    // emigrants are cloned before any island takes in migrants, so that none
+    // passes on teams it has just received.
+    void migrate(Islands& islands) const {
+        size_t const n_islands = islands.size();
+        std::vector<Population::NodeTeams> migrants(n_islands);
+
+        for (size_t src = 0; src < n_islands; ++src) {
+            auto const& teams = *islands.at(src)->front_buffer();
+            size_t const n_emigrants =
+                std::min(OPTIONS.ga_migration_size,
+                         islands.at(src)->cutoffs().survivors);
+
+            for (size_t dst = 0; dst < n_islands; ++dst) {
+                bool const is_neighbour =
+                    OPTIONS.ga_migration_topology == "all" ?
+                    dst != src :
+                    dst == (src + 1) % n_islands;
+
+                if (is_neighbour) {
+                    for (size_t rank = 0; rank < n_emigrants; ++rank) {
+                        migrants.at(dst).push_back(teams.at(rank)->clone());
+                    }
+                }
+            }
+        }
+
+        for (size_t dst = 0; dst < n_islands; ++dst) {
+            islands.at(dst)->immigrate(migrants.at(dst));
+        }
+
+        JUtil.info("Migrated up to %zu teams per island (%s)\n",
+                   OPTIONS.ga_migration_size,
+                   OPTIONS.ga_migration_topology.c_str());
+    }
+
     void run(WorkArea const& work_area, TeamSPMaxHeap& output) {
         reset();
         start_time_in_us_ = JUtil.get_timestamp_us();
 
+        // Islands run their generations side by side, each with a team of
+        // threads for its own parallel loops.
+        int const max_active_levels = omp_get_max_active_levels();
+        if (OPTIONS.ga_islands > 1) {
+            omp_set_max_active_levels(2);
+        }
+
         // Activate ProtoTerm profile if there is one.
         InputManager::mutable_xdb().activate_ptterm_profile(work_area.ptterm_profile);
 
-        auto seed = OPTIONS.seed;  // Reentrant seed.
+        // Every restart starts from the same prior solutions.
+        seeding::Seeds const seeds = OPTIONS.seed_solutions.empty() ?
+                                     seeding::Seeds() :
+                                     seeding::load(OPTIONS.seed_solutions,
+                                                   work_area);
+        if (not OPTIONS.seed_solutions.empty()) {
+            JUtil.info("Loaded %zu seed solutions for %s\n",
+                       seeds.size(), work_area.name.c_str());
+        }
+
+        // A resumed restart continues with the islands of the checkpoint.
+        Islands islands;
+        bool solved = false;
+        if (OPTIONS.resume and checkpoint::exists(work_area)) {
+            solved = not load_checkpoint(work_area, islands, output);
+        }
+
+        SolutionArchive archive(
+            output, std::min(OPTIONS.keep_n, OPTIONS.ga_pop_size));
 
-        while (OPTIONS.ga_max_restarts == 0 or
-                restart_id < OPTIONS.ga_max_restarts) {
+        while (not solved and
+                (OPTIONS.ga_max_restarts == 0 or
+                 restart_id < OPTIONS.ga_max_restarts)) {
             should_restart_ga_ = false;
 
-            // Initialize population and solution list.
-            Population population = Population(&work_area, seed);
+            // Initialize islands and solution list.
+            size_t const n_islands = OPTIONS.ga_islands;
+            bool const steady_state = OPTIONS.ga_mode == "steady_state";
+            if (islands.empty()) {
+                // Keyed so that restarts and islands draw apart from one
+                // another.
+                uint64_t const restart_key =
+                    random::derive(OPTIONS.seed, restart_id);
+                for (size_t i = 0; i < n_islands; ++i) {
+                    islands.push_back(std::make_unique<Population>(
+                                          &work_area,
+                                          random::derive(restart_key, i),
+                                          island_cutoffs(),
+                                          seeds));
+                }
 
-            print_start_msg(work_area);
+                tot_gen_time = 0.0f;
+                stagnant_count = 0;
+                gen_id = 0;
+            }
 
-            tot_gen_time = 0.0f;
-            stagnant_count = 0;
+            print_start_msg(work_area);
 
             if (OPTIONS.dry_run) break;
 
-            gen_id = 0;
             while (OPTIONS.ga_max_iters == 0 or itr_id < OPTIONS.ga_max_iters) {
                 double const gen_start_time = JUtil.get_timestamp_us();
 
-                population.evolve();
-                print_pop("After evolve", population);
+                if (steady_state) {
+                    auto& population = *islands.front();
+                    population.evolve_steady_state();
 
-                population.rank();
-                print_pop("Post rank", population);
-
-                population.select();
-                print_pop("Post select", population);
+                    // Sort the best teams to the front for the output.
+                    population.rank();
+                    print_pop("Post rank", population);
+                }
+                else if (n_islands == 1) {
+                    run_generation(*islands.front(), /*print=*/ true);
+                }
+                else {
+                    // Each island gets an equal share of the threads for
+                    // its own parallel loops.
+                    int const n_threads = omp_get_max_threads();
+                    int const n_island_threads =
+                        std::max(1, n_threads / (int) n_islands);
+
+                    #pragma omp parallel for schedule(dynamic, 1) \
+                        num_threads(std::min(n_threads, (int) n_islands))
+                    for (size_t i = 0; i < n_islands; ++i) {
+                        omp_set_num_threads(n_island_threads);
+                        run_generation(*islands.at(i), /*print=*/ false);
+                    }
+
+                    if (OPTIONS.ga_migration_interval and
+                            (gen_id + 1) % OPTIONS.ga_migration_interval == 0) {
+                        migrate(islands);
+                    }
+                }
 
-                summarize_generation(population,
-                                        gen_start_time,
-                                        output);
+                summarize_generation(work_area,
+                                     islands,
+                                     gen_start_time,
+                                     archive);
 
                 if (should_restart_ga_ or score_satisfied_) break;
 
-                population.swap_buffer();
+                if (not steady_state) {
+                    for (auto& island : islands) {
+                        island->swap_buffer();
+                    }
+                }
 
                 gen_id++;
                 itr_id++;
+
+                if (OPTIONS.checkpoint_interval and
+                        itr_id % OPTIONS.checkpoint_interval == 0) {
+                    save_checkpoint(work_area, islands, output);
+                }
             }  // generation
 
+            for (auto const& island : islands) {
+                mutation_stats_ += island->scheduler().totals();
+            }
+            islands.clear();
+
             if (score_satisfied_) break;
             restart_id++;
         }  // restart
 
-        print_end_msg();
+        // Resuming skips work areas that were solved.
+        if (OPTIONS.checkpoint_interval and not OPTIONS.dry_run) {
+            save_checkpoint(work_area, Islands(), output);
+        }
+
+        omp_set_max_active_levels(max_active_levels);
+        print_end_msg(work_area);
     }
 };
 
@@ -296,6 +603,11 @@ EvolutionSolver::EvolutionSolver(size_t const debug_pop_print_n) :
 /* dtors */
 EvolutionSolver::~EvolutionSolver() {}
 
+/* accessors */
+mutation::Stats const& EvolutionSolver::mutation_stats() const {
+    return pimpl_->mutation_stats_;
+}
+
 /* modifiers */
 void EvolutionSolver::run(WorkArea const& work_area, TeamSPMaxHeap& output) {
     return pimpl_->run(work_area, output);
@@ -0,0 +1,80 @@
+#include "first_rank_table.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "omp.h"
+
+#include "test_stat.h"
+#include "random_utils.h"
+#include "jutil.h"
+
+namespace elfin {
+
+/* tests */
+TestStat FirstRankTable::test() {
+    TestStat ts;
+
+    // Inserts every (checksum, rank) pair several times from many threads in
+    // a shuffled order, then expects the lowest rank of each checksum.
+    auto const check = [&](char const* const name,
+                           size_t const n_ranks,
+                           auto const& crc_of_rank) {
+        std::vector<size_t> order;
+        for (size_t rank = 0; rank < n_ranks; ++rank) {
+            for (size_t repeat = 0; repeat < 4; ++repeat) {
+                order.push_back(rank);
+            }
+        }
+        random::Stream seed(0x7ab1e);
+        for (size_t i = order.size(); i > 1; --i) {
+            std::swap(order[i - 1], order[random::get_dice(i, seed)]);
+        }
+
+        FirstRankTable table(n_ranks);
+        #pragma omp parallel for schedule(dynamic, 16)
+        for (size_t i = 0; i < order.size(); ++i) {
+            table.insert(crc_of_rank(order[i]), order[i]);
+        }
+
+        ts.tests++;
+        size_t n_bad = 0;
+        for (size_t rank = 0; rank < n_ranks; ++rank) {
+            Crc32 const crc = crc_of_rank(rank);
+            size_t first = rank;
+            while (first > 0 and crc_of_rank(first - 1) == crc) {
+                first--;
+            }
+            n_bad += table.first_rank(crc) != first;
+        }
+
+        if (n_bad) {
+            ts.errors++;
+            JUtil.error("FirstRankTable %s test had %zu wrong ranks\n",
+                        name, n_bad);
+        }
+    };
+
+    size_t const n_ranks = 1000;
+
+    // Teams are ranked by score, so copies of a team hold consecutive ranks.
+    check("duplicates", n_ranks, [](size_t const rank) {
+        return Crc32(0x9e3779b9 * (rank / 7 + 1));
+    });
+
+    // Checksums that all start from the last slot probe past the end of the
+    // table and back from its start. Table sizes are powers of two, so equal
+    // low bits land in the same slot.
+    check("collisions", n_ranks, [](size_t const rank) {
+        return Crc32(((rank / 4) << 16) | 0xffff);
+    });
+
+    // As many checksums as ranks, which is as full as the table gets.
+    check("full", n_ranks, [](size_t const rank) {
+        return Crc32((rank << 16) | 0xffff);
+    });
+
+    return ts;
+}
+
+}  /* elfin */
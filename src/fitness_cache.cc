@@ -0,0 +1,154 @@
+#include "fitness_cache.h"
+
+namespace elfin {
+
+static uint64_t pack(FitnessCache::Entry const& entry) {
+    uint32_t score_bits;
+    std::memcpy(&score_bits, &entry.score, sizeof(score_bits));
+    return (uint64_t(score_bits) << 32) | entry.ref_id;
+}
+
+static FitnessCache::Entry unpack(uint64_t const value) {
+    FitnessCache::Entry entry;
+    uint32_t const score_bits = value >> 32;
+    std::memcpy(&entry.score, &score_bits, sizeof(score_bits));
+    entry.ref_id = value & 0xffffffff;
+    return entry;
+}
+
+/* public */
+/* ctors */
+FitnessCache::FitnessCache(size_t const capacity) {
+    if (capacity == 0) {
+        return;
+    }
+
+    // At least one bucket per shard.
+    size_t n_buckets = N_SHARDS;
+    while (n_buckets * WAYS < capacity) {
+        n_buckets <<= 1;
+    }
+    mask_ = n_buckets - 1;
+
+    buckets_.reset(new Bucket[n_buckets]);
+    for (size_t i = 0; i < n_buckets; ++i) {
+        for (auto& slot : buckets_[i].slots) {
+            slot.key.store(EMPTY, std::memory_order_relaxed);
+            slot.value.store(0, std::memory_order_relaxed);
+        }
+        buckets_[i].referenced.store(0, std::memory_order_relaxed);
+        buckets_[i].hand.store(0, std::memory_order_relaxed);
+    }
+
+    shards_.reset(new Shard[N_SHARDS]);
+    for (size_t i = 0; i < N_SHARDS; ++i) {
+        shards_[i].hits.store(0, std::memory_order_relaxed);
+        shards_[i].misses.store(0, std::memory_order_relaxed);
+        shards_[i].inserts.store(0, std::memory_order_relaxed);
+        shards_[i].evictions.store(0, std::memory_order_relaxed);
+    }
+}
+
+/* accessors */
+FitnessCache::Stats FitnessCache::stats() const {
+    Stats res;
+    if (enabled()) {
+        for (size_t i = 0; i < N_SHARDS; ++i) {
+            res.hits += shards_[i].hits.load(std::memory_order_relaxed);
+            res.misses += shards_[i].misses.load(std::memory_order_relaxed);
+            res.inserts += shards_[i].inserts.load(std::memory_order_relaxed);
+            res.evictions += shards_[i].evictions.load(std::memory_order_relaxed);
+        }
+    }
+    return res;
+}
+
+bool FitnessCache::lookup(Key key, Entry& entry) const {
+    if (not enabled()) {
+        return false;
+    }
+
+    key = normalize(key);
+    Bucket& bucket = bucket_of(key);
+    for (size_t way = 0; way < WAYS; ++way) {
+        Slot& slot = bucket.slots[way];
+        if (slot.key.load(std::memory_order_acquire) != key) {
+            continue;
+        }
+
+        uint64_t const value = slot.value.load(std::memory_order_relaxed);
+
+        // If the key is still there, no writer took the slot in between.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.key.load(std::memory_order_relaxed) != key) {
+            continue;
+        }
+
+        bucket.referenced.fetch_or(1 << way, std::memory_order_relaxed);
+        shard_of(key).hits.fetch_add(1, std::memory_order_relaxed);
+        entry = unpack(value);
+        return true;
+    }
+
+    shard_of(key).misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/* modifiers */
+void FitnessCache::insert(Key key, Entry const& entry) {
+    if (not enabled()) {
+        return;
+    }
+
+    key = normalize(key);
+    Bucket& bucket = bucket_of(key);
+    Shard& shard = shard_of(key);
+
+    auto const write = [&](size_t const way) {
+        Slot& slot = bucket.slots[way];
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.value.store(pack(entry), std::memory_order_relaxed);
+        slot.key.store(key, std::memory_order_release);
+        bucket.referenced.fetch_and(~(1 << way), std::memory_order_relaxed);
+        shard.inserts.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    // Another thread may have cached the same team already.
+    for (auto const& slot : bucket.slots) {
+        if (slot.key.load(std::memory_order_relaxed) == key) {
+            return;
+        }
+    }
+
+    for (size_t way = 0; way < WAYS; ++way) {
+        Key expected = EMPTY;
+        if (bucket.slots[way].key.compare_exchange_strong(
+                    expected, BUSY, std::memory_order_relaxed)) {
+            write(way);
+            return;
+        }
+    }
+
+    // CLOCK: a referenced slot gets a second chance. Two rounds are enough
+    // unless other threads keep hitting or taking slots.
+    for (size_t step = 0; step < 2 * WAYS; ++step) {
+        size_t const way =
+            bucket.hand.fetch_add(1, std::memory_order_relaxed) % WAYS;
+        uint8_t const bit = 1 << way;
+        if (bucket.referenced.fetch_and(~bit, std::memory_order_relaxed) & bit) {
+            continue;
+        }
+
+        Slot& slot = bucket.slots[way];
+        Key victim = slot.key.load(std::memory_order_relaxed);
+        if (victim != BUSY and
+                slot.key.compare_exchange_strong(
+                    victim, BUSY, std::memory_order_relaxed)) {
+            write(way);
+            shard.evictions.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+}  /* elfin */
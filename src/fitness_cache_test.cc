@@ -0,0 +1,146 @@
+#include "fitness_cache.h"
+
+#include <vector>
+
+#include "omp.h"
+
+#include "test_stat.h"
+#include "jutil.h"
+
+namespace elfin {
+
+/* tests */
+TestStat FitnessCache::test() {
+    TestStat ts;
+
+    // Entries stored under each key must be recognizable, so that torn or
+    // misplaced values show up.
+    auto const entry_of = [](Key const key) {
+        Entry entry;
+        entry.score = (float) (key % 1000003);
+        entry.ref_id = key >> 40;
+        return entry;
+    };
+    auto const key_of = [](size_t const i) {
+        return mix(Key(0x5eed), (uint64_t) i);
+    };
+
+    // A disabled cache misses and stores nothing.
+    {
+        ts.tests++;
+        FitnessCache cache(0);
+        Entry entry;
+        cache.insert(key_of(0), entry_of(key_of(0)));
+        if (cache.enabled() or cache.lookup(key_of(0), entry)) {
+            ts.errors++;
+            JUtil.error("Disabled fitness cache returned an entry\n");
+        }
+    }
+
+    // Up to capacity, most entries are kept and all come back intact.
+    {
+        FitnessCache cache(4096);
+        size_t const n_keys = cache.capacity() / 2;
+        for (size_t i = 0; i < n_keys; ++i) {
+            cache.insert(key_of(i), entry_of(key_of(i)));
+        }
+
+        size_t n_found = 0;
+        for (size_t i = 0; i < n_keys; ++i) {
+            Entry entry;
+            if (cache.lookup(key_of(i), entry)) {
+                n_found++;
+
+                ts.tests++;
+                Entry const expected = entry_of(key_of(i));
+                if (entry.score != expected.score or
+                        entry.ref_id != expected.ref_id) {
+                    ts.errors++;
+                    JUtil.error("Fitness cache returned %f/%u for key #%zu "
+                                "instead of %f/%u\n",
+                                entry.score, entry.ref_id, i,
+                                expected.score, expected.ref_id);
+                }
+            }
+        }
+
+        ts.tests++;
+        auto const stats = cache.stats();
+        if (n_found < n_keys * 9 / 10 or
+                stats.hits != n_found or
+                stats.misses != n_keys - n_found) {
+            ts.errors++;
+            JUtil.error("Fitness cache kept %zu of %zu entries "
+                        "(%zu hits, %zu misses)\n",
+                        n_found, n_keys, stats.hits, stats.misses);
+        }
+    }
+
+    // Far past capacity, the cache stays bounded and keeps entries that are
+    // hit over those that are not.
+    {
+        FitnessCache cache(1024);
+        size_t const n_hot = 64;
+        for (size_t i = 0; i < n_hot; ++i) {
+            cache.insert(key_of(i), entry_of(key_of(i)));
+        }
+
+        Entry entry;
+        for (size_t i = n_hot; i < 20 * cache.capacity(); ++i) {
+            cache.insert(key_of(i), entry_of(key_of(i)));
+            cache.lookup(key_of(i % n_hot), entry);
+        }
+
+        ts.tests++;
+        size_t n_hot_found = 0;
+        for (size_t i = 0; i < n_hot; ++i) {
+            n_hot_found += cache.lookup(key_of(i), entry);
+        }
+        if (n_hot_found < n_hot / 2) {
+            ts.errors++;
+            JUtil.error("Fitness cache only kept %zu of %zu hot entries\n",
+                        n_hot_found, n_hot);
+        }
+
+        ts.tests++;
+        auto const stats = cache.stats();
+        if (stats.inserts - stats.evictions > cache.capacity()) {
+            ts.errors++;
+            JUtil.error("Fitness cache holds %zu entries past capacity %zu\n",
+                        stats.inserts - stats.evictions, cache.capacity());
+        }
+    }
+
+    // Threads inserting and looking up overlapping keys never read values
+    // of other keys.
+    {
+        FitnessCache cache(2048);
+        size_t const n_keys = 4 * cache.capacity();
+        size_t n_bad = 0;
+
+        #pragma omp parallel for reduction(+:n_bad)
+        for (size_t i = 0; i < 50 * n_keys; ++i) {
+            Key const key = key_of(i * 7919 % n_keys);
+            Entry entry;
+            if (cache.lookup(key, entry)) {
+                Entry const expected = entry_of(key);
+                n_bad += entry.score != expected.score or
+                         entry.ref_id != expected.ref_id;
+            }
+            else {
+                cache.insert(key, entry_of(key));
+            }
+        }
+
+        ts.tests++;
+        if (n_bad) {
+            ts.errors++;
+            JUtil.error("Fitness cache returned %zu wrong entries "
+                        "under concurrent use\n", n_bad);
+        }
+    }
+
+    return ts;
+}
+
+}  /* elfin */
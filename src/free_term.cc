@@ -21,7 +21,7 @@ bool FreeTerm::operator==(FreeTerm const& other) const {
            chain_id == other.chain_id;
 }
 
-ProtoLink const& FreeTerm::random_proto_link(uint32_t& seed) const {
+ProtoLink const& FreeTerm::random_proto_link(random::Stream& seed) const {
     return get_ptterm().pick_random_link(term, seed);
 }
 
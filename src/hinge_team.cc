@@ -3,6 +3,7 @@
 #include "input_manager.h"
 #include "ui_joint.h"
 #include "priv_impl.h"
+#include "checkpoint.h"
 
 namespace elfin {
 
@@ -80,6 +81,12 @@ bool HingeTeam::is_mutable(NodeKey const tip) const {
     return tip != hinge_;
 }
 
+bool HingeTeam::in_spec_frame() const {
+    // Only fixed hinges are placed where the spec put the hinge; loose ones
+    // are aligned before scoring.
+    return score_func_ == scoring::score_unaligned;
+}
+
 void HingeTeam::postprocess_json(JSON& output) const {
     if (output.size() > 0) {
         // Skip first hinge.
@@ -88,6 +95,11 @@ void HingeTeam::postprocess_json(JSON& output) const {
 }
 
 /* modifiers */
+void HingeTeam::unshare_nodes() {
+    PathTeam::unshare_nodes();
+    hinge_ = hinge_ ? nodes_->counterpart(hinge_) : nullptr;
+}
+
 void HingeTeam::reset() {
     PathTeam::reset();
     hinge_ui_joint_ = nullptr;
@@ -121,10 +133,13 @@ void HingeTeam::calc_checksum() {
 void HingeTeam::calc_score() {
     score_ = INFINITY;
 
-    auto const& my_points = gen_path().collect_points();
+    thread_local V3fList my_points;
+    gen_path().collect_points(my_points);
     auto const& ref_path = work_area_->path_map.at(hinge_ui_joint_);
 
-    score_ = score_func_(my_points, ref_path);
+    score_ = score_func_(
+                 my_points,
+                 work_area_->ref_path(hinge_ui_joint_, my_points.size()));
 
     scored_path_ = &ref_path;
 }
@@ -159,7 +174,7 @@ void HingeTeam::virtual_implement_recipe(
 /* public */
 /* ctors */
 HingeTeam::HingeTeam(WorkArea const* const wa,
-                     uint32_t const seed,
+                     random::Stream const& seed,
                      bool const loose) :
     PathTeam(wa, seed),
     pimpl_(new_pimpl<PImpl>(*this)),
@@ -185,11 +200,18 @@ HingeTeam::HingeTeam(HingeTeam&& other)  :
 /* dtors */
 HingeTeam::~HingeTeam() {}
 
+/* accessors */
+void HingeTeam::write_checkpoint(checkpoint::Writer& writer) const {
+    PathTeam::write_checkpoint(writer);
+    writer.put_string(hinge_ui_joint_ ? hinge_ui_joint_->name : "");
+    nodes_->write_node(writer, hinge_);
+}
+
 /* modifiers */
 HingeTeam& HingeTeam::operator=(HingeTeam const& other) {
     PathTeam::operator=(other);
     hinge_ui_joint_ = other.hinge_ui_joint_;
-    hinge_ = other.hinge_ ? nk_map_.at(other.hinge_) : nullptr;
+    hinge_ = other.hinge_;
     score_func_ = other.score_func_;
     return *this;
 }
@@ -202,4 +224,53 @@ HingeTeam& HingeTeam::operator=(HingeTeam && other) {
     return *this;
 }
 
+void HingeTeam::read_checkpoint(checkpoint::Reader& reader) {
+    PathTeam::read_checkpoint(reader);
+
+    auto const& omap = work_area_->occupied_joints;
+    std::string const joint_name = reader.get_string();
+    auto const itr = omap.find(joint_name);
+    PANIC_IF(itr == end(omap),
+             CouldNotParse("Checkpoint refers to missing hinge " + joint_name));
+    hinge_ui_joint_ = itr->second;
+
+    hinge_ = nodes_->read_node(reader);
+}
+
+void HingeTeam::pack_points(scoring::PointBatch& batch,
+                            size_t const set) const
+{
+    PathTeam::pack_points(batch, set);
+
+    // Only loose hinges are aligned before scoring. Fixed hinges are cheap to
+    // score unaligned in finish_score().
+    if (score_func_ == scoring::score_aligned) {
+        auto const& ref_path = work_area_->path_map.at(hinge_ui_joint_);
+        batch.set_ref_mask(set, 1 << batch.ref_id(&ref_path));
+    }
+    else {
+        batch.set_ref_mask(set, 0);
+    }
+}
+
+void HingeTeam::finish_score(scoring::PointBatch const& batch,
+                             size_t const set)
+{
+    if (batch.ref_mask(set)) {
+        auto const& ref_path = work_area_->path_map.at(hinge_ui_joint_);
+        score_ = batch.score(set, batch.ref_id(&ref_path));
+        scored_path_ = &ref_path;
+    }
+    else {
+        calc_score();
+    }
+
+    // Teams already past the cutoff will not survive; spare the penalty.
+    // Only then is the score final and worth caching.
+    if (score_ <= batch.cutoff()) {
+        penalize_collision();
+        save_cached_score();
+    }
+}
+
 }  /* elfin */
\ No newline at end of file
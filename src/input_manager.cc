@@ -2,6 +2,7 @@
 
 #include "arg_parser.h"
 #include "parallel_utils.h"
+#include "scoring.h"
 
 namespace elfin {
 
@@ -15,22 +16,25 @@ Database const& XDB =
 GATimes const& GA_TIMES =
     InputManager::ga_times();
 
-/* protected */
-void InputManager::setup_cutoffs() {
-    Cutoffs& cutoffs = instance().cutoffs_;
+Cutoffs calc_cutoffs(size_t const pop_size) {
+    Cutoffs cutoffs = {};  // zero struct
 
-    cutoffs = {};  // zero struct
-
-    cutoffs.pop_size =
-        OPTIONS.ga_pop_size;
+    cutoffs.pop_size = pop_size;
 
     // Force survivors > 0
     cutoffs.survivors =
         std::max((size_t) 1,
-                 (size_t) std::round(OPTIONS.ga_survive_rate * OPTIONS.ga_pop_size));
+                 (size_t) std::round(OPTIONS.ga_survive_rate * pop_size));
 
     cutoffs.non_survivors =
-        (OPTIONS.ga_pop_size - cutoffs.survivors);
+        (pop_size - cutoffs.survivors);
+
+    return cutoffs;
+}
+
+/* protected */
+void InputManager::setup_cutoffs() {
+    instance().cutoffs_ = calc_cutoffs(OPTIONS.ga_pop_size);
 }
 
 /* public */
@@ -63,6 +67,7 @@ void InputManager::parse(int const argc, char const** const argv, bool const ski
     setup_cutoffs();
 
     parallel::init();
+    scoring::init();
 }
 
 }  /* elfin */
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "link.h"
 
 #include "node.h"
+#include "node_pool.h"
 #include "path_generator.h"
 
 namespace elfin {
@@ -33,9 +34,9 @@ PathGenerator Link::gen_path() const {
 }
 
 /* modifiers */
-void Link::update_node_ptrs(NodeKeyMap const& nam) {
-    src_.node = nam.at(src_.node);
-    dst_.node = nam.at(dst_.node);
+void Link::update_node_ptrs(NodePool const& pool) {
+    src_.node = pool.counterpart(src_.node);
+    dst_.node = pool.counterpart(dst_.node);
 }
 
 /* printers */
@@ -4,6 +4,9 @@
 #include <unordered_set>
 #include <algorithm>
 
+#include "random_utils.h"
+#include "checkpoint.h"
+
 namespace elfin {
 
 namespace mutation {
@@ -44,6 +47,219 @@ Counter gen_counter() {
     return res;
 }
 
+/* Record */
+/* accessors */
+float Record::gain() const {
+    // Scores are costs, so lower is better. A perfect or unscored mother
+    // leaves nothing to gain.
+    if (not (child_score < parent_score) or
+            not (parent_score > 0) or
+            not std::isfinite(parent_score)) {
+        return 0;
+    }
+    return (parent_score - child_score) / parent_score;
+}
+
+/* Stats */
+/* accessors */
+JSON Stats::to_json() const {
+    JSON output;
+    for (size_t i = 0; i < N_MODES; ++i) {
+        auto const& ms = modes_[i];
+        if (ms.tries == 0 and ms.successes == 0) {
+            continue;
+        }
+
+        JSON mode_json;
+        mode_json["tries"] = ms.tries;
+        mode_json["successes"] = ms.successes;
+        mode_json["improvements"] = ms.improvements;
+        mode_json["cost_ns"] = ms.cost_ns;
+        mode_json["cost_nodes"] = ms.cost_nodes;
+        mode_json["gain"] = ms.gain;
+        output[ModeToCStr(static_cast<Mode>(i))] = mode_json;
+    }
+    return output;
+}
+
+/* modifiers */
+void Stats::add(Record const& record) {
+    for (size_t i = 0; i < N_MODES; ++i) {
+        if (record.tried & (1u << i)) {
+            modes_[i].tries++;
+            modes_[i].cost_ns += record.cost_ns[i];
+            modes_[i].cost_nodes += record.cost_nodes[i];
+        }
+    }
+
+    auto& ms = modes_.at(static_cast<size_t>(record.mode));
+    ms.successes++;
+
+    float const gain = record.gain();
+    if (gain > 0) {
+        ms.improvements++;
+        ms.gain += gain;
+    }
+}
+
+Stats& Stats::operator+=(Stats const& other) {
+    for (size_t i = 0; i < N_MODES; ++i) {
+        modes_[i].tries += other.modes_[i].tries;
+        modes_[i].successes += other.modes_[i].successes;
+        modes_[i].improvements += other.modes_[i].improvements;
+        modes_[i].cost_ns += other.modes_[i].cost_ns;
+        modes_[i].cost_nodes += other.modes_[i].cost_nodes;
+        modes_[i].gain += other.modes_[i].gain;
+    }
+    return *this;
+}
+
+void Stats::decay(double const factor) {
+    for (auto& ms : modes_) {
+        ms.tries *= factor;
+        ms.successes *= factor;
+        ms.improvements *= factor;
+        ms.cost_ns *= factor;
+        ms.cost_nodes *= factor;
+        ms.gain *= factor;
+    }
+}
+
+/* Scheduler */
+// Weight of the generations before the last one, halving about every 7
+// generations.
+static double const RECENT_DECAY = 0.9;
+
+// Roughly what a child of a small team costs.
+static float const DEFAULT_CHILD_COST_NS = 1e5;
+static float const DEFAULT_CHILD_COST_NODES = 10;
+
+/* ctors */
+Scheduler::Scheduler(bool const adaptive) :
+    adaptive_(adaptive) {
+    weights_.fill(1);
+}
+
+/* accessors */
+Mode Scheduler::pop(ModeList& modes, random::Stream& seed) const {
+    if (not adaptive_) {
+        return random::pop(modes, seed);
+    }
+
+    DEBUG_NOMSG(modes.empty());
+
+    float total = 0;
+    for (auto const mode : modes) {
+        total += weight(mode);
+    }
+
+    // Falls on the last mode if rounding leaves dice past the total.
+    float dice = random::get_dice_0to1(seed) * total;
+    size_t idx = 0;
+    while (idx + 1 < modes.size() and dice >= weight(modes[idx])) {
+        dice -= weight(modes[idx]);
+        idx++;
+    }
+
+    Mode const ret = modes[idx];
+    std::swap(modes[idx], modes.back());
+    modes.pop_back();
+
+    return ret;
+}
+
+float Scheduler::child_cost_ns() const {
+    // Every child counts once as a success, under NONE if all modes failed.
+    double cost_ns = 0, children = 0;
+    for (size_t i = 0; i < N_MODES; ++i) {
+        auto const& ms = recent_.at(static_cast<Mode>(i));
+        cost_ns += ms.cost_ns;
+        children += ms.successes;
+    }
+    return children > 0 ? cost_ns / children : DEFAULT_CHILD_COST_NS;
+}
+
+float Scheduler::child_cost_nodes() const {
+    double cost_nodes = 0, children = 0;
+    for (size_t i = 0; i < N_MODES; ++i) {
+        auto const& ms = recent_.at(static_cast<Mode>(i));
+        cost_nodes += ms.cost_nodes;
+        children += ms.successes;
+    }
+    return children > 0 ? cost_nodes / children : DEFAULT_CHILD_COST_NODES;
+}
+
+void Scheduler::write_checkpoint(checkpoint::Writer& writer) const {
+    writer.put(recent_);
+    writer.put(totals_);
+    writer.put(weights_);
+}
+
+/* modifiers */
+void Scheduler::update(std::vector<Record> const& records) {
+    Stats latest;
+    for (auto const& record : records) {
+        latest.add(record);
+    }
+    totals_ += latest;
+
+    recent_.decay(RECENT_DECAY);
+    recent_ += latest;
+
+    if (not adaptive_) {
+        return;
+    }
+
+    // Payoff is gain per node touched, with tries that failed counting
+    // towards cost. Modes with less than one recent try have too little to
+    // go by, and are left out until the others are weighed.
+    ModeList const modes = gen_mode_list();
+    std::array<double, N_MODES> payoffs{};
+    double max_payoff = 0;
+    double total_tries = 0;
+    for (auto const mode : modes) {
+        auto const& ms = recent_.at(mode);
+        if (ms.tries < 1) {
+            continue;
+        }
+
+        double const payoff = ms.cost_nodes > 0 ? ms.gain / ms.cost_nodes : 0;
+        payoffs[static_cast<size_t>(mode)] = payoff;
+        max_payoff = std::max(max_payoff, payoff);
+        total_tries += ms.tries;
+    }
+
+    float max_weight = 0;
+    for (auto const mode : modes) {
+        size_t const i = static_cast<size_t>(mode);
+        double const tries = recent_.at(mode).tries;
+        if (tries < 1) {
+            continue;
+        }
+
+        double const relative_payoff =
+            max_payoff > 0 ? payoffs[i] / max_payoff : 0;
+        double const bonus = std::sqrt(2 * std::log(total_tries) / tries);
+        weights_[i] = relative_payoff + bonus;
+        max_weight = std::max(max_weight, weights_[i]);
+    }
+
+    // Unmeasured modes are drawn like the best one, which soon measures
+    // them, rather than sending every mode back to uniform odds.
+    for (auto const mode : modes) {
+        if (recent_.at(mode).tries < 1) {
+            weights_[static_cast<size_t>(mode)] =
+                max_weight > 0 ? max_weight : 1;
+        }
+    }
+}
+
+void Scheduler::read_checkpoint(checkpoint::Reader& reader) {
+    recent_ = reader.get<Stats>();
+    totals_ = reader.get<Stats>();
+    weights_ = reader.get<decltype(weights_)>();
+}
+
 }  /* mutation */
 
 }  /* elfin */
\ No newline at end of file
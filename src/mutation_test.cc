@@ -0,0 +1,143 @@
+#include "mutation.h"
+
+#include "test_stat.h"
+#include "random_utils.h"
+
+namespace elfin {
+
+namespace mutation {
+
+/* tests */
+TestStat test() {
+    TestStat ts;
+
+    // Gain is the relative improvement over the mother, never negative.
+    {
+        Record record;
+        record.parent_score = 8;
+        record.child_score = 6;
+
+        ts.tests++;
+        if (std::abs(record.gain() - 0.25f) > 1e-6) {
+            ts.errors++;
+            JUtil.error("Record gain %f, expected 0.25\n", record.gain());
+        }
+
+        ts.tests++;
+        record.child_score = INFINITY;
+        if (record.gain() != 0) {
+            ts.errors++;
+            JUtil.error("Record gain of a worse child is %f\n",
+                        record.gain());
+        }
+    }
+
+    // Uniform scheduling draws modes exactly as random::pop() does.
+    {
+        Scheduler const scheduler(/*adaptive=*/ false);
+        random::Stream seed(0x3e7a), ref_seed = seed;
+        auto modes = gen_mode_list(), ref_modes = modes;
+
+        ts.tests++;
+        while (not modes.empty()) {
+            Mode const mode = scheduler.pop(modes, seed);
+            Mode const ref_mode = random::pop(ref_modes, ref_seed);
+            if (mode != ref_mode) {
+                ts.errors++;
+                JUtil.error("Uniform schedule drew %s instead of %s\n",
+                            ModeToCStr(mode), ModeToCStr(ref_mode));
+                break;
+            }
+        }
+    }
+
+    // Adaptive scheduling favours the mode with the best gain per node
+    // touched, but keeps drawing the others.
+    {
+        Scheduler scheduler(/*adaptive=*/ true);
+        ModeList const all_modes = gen_mode_list();
+
+        std::vector<Record> records;
+        for (size_t i = 0; i < 100; ++i) {
+            for (auto const mode : all_modes) {
+                Record record;
+                record.add_try(mode, 1e4, mode == Mode::INSERT ? 10 : 100);
+                record.mode = mode;
+                record.parent_score = 10;
+                record.child_score = 9;
+                records.push_back(record);
+            }
+        }
+        scheduler.update(records);
+
+        ts.tests++;
+        if (scheduler.totals().at(Mode::INSERT).successes != 100) {
+            ts.errors++;
+            JUtil.error("Scheduler recorded %f INSERT successes\n",
+                        scheduler.totals().at(Mode::INSERT).successes);
+        }
+
+        random::Stream seed(0x3e7b);
+        Counter firsts = gen_counter();
+        size_t const n_draws = 10000;
+        for (size_t i = 0; i < n_draws; ++i) {
+            auto modes = all_modes;
+            firsts[scheduler.pop(modes, seed)]++;
+        }
+
+        for (auto const mode : all_modes) {
+            ts.tests++;
+            bool const is_best = mode == Mode::INSERT;
+            if (firsts[mode] == 0 or
+                    (not is_best and firsts[mode] >= firsts[Mode::INSERT])) {
+                ts.errors++;
+                JUtil.error("Adaptive schedule drew %s first %zu times "
+                            "(INSERT %zu times)\n",
+                            ModeToCStr(mode),
+                            firsts[mode],
+                            firsts[Mode::INSERT]);
+            }
+        }
+    }
+
+    // A mode without recent tries is drawn like the best mode, and the
+    // others keep their weights.
+    {
+        Scheduler scheduler(/*adaptive=*/ true);
+
+        std::vector<Record> records;
+        for (size_t i = 0; i < 100; ++i) {
+            for (auto const mode : gen_mode_list()) {
+                if (mode == Mode::REGENERATE) {
+                    continue;
+                }
+
+                Record record;
+                record.add_try(mode, 1e4, mode == Mode::INSERT ? 10 : 100);
+                record.mode = mode;
+                record.parent_score = 10;
+                record.child_score = 9;
+                records.push_back(record);
+            }
+        }
+        scheduler.update(records);
+
+        ts.tests++;
+        float const insert_weight = scheduler.weight(Mode::INSERT);
+        if (scheduler.weight(Mode::REGENERATE) != insert_weight or
+                not (scheduler.weight(Mode::DELETE) < insert_weight)) {
+            ts.errors++;
+            JUtil.error("Scheduler weighed unmeasured REGENERATE %f, "
+                        "DELETE %f and INSERT %f\n",
+                        scheduler.weight(Mode::REGENERATE),
+                        scheduler.weight(Mode::DELETE),
+                        insert_weight);
+        }
+    }
+
+    return ts;
+}
+
+}  /* mutation */
+
+}  /* elfin */
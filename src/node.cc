@@ -22,9 +22,9 @@ Link const* Node::find_link_to(NodeKey dst_node) const {
 }
 
 /* modifiers */
-void Node::update_link_ptrs(NodeKeyMap const& nam) {
+void Node::update_link_ptrs(NodePool const& pool) {
     for (Link& link : links_) {
-        link.update_node_ptrs(nam);
+        link.update_node_ptrs(pool);
     }
 }
 
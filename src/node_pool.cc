@@ -0,0 +1,373 @@
+#include "node_pool.h"
+
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <sys/mman.h>
+
+#include "debug_utils.h"
+#include "checkpoint.h"
+#include "input_manager.h"
+
+namespace elfin {
+
+static_assert(sizeof(NodePool::Chunk) <= NodeArena::SLAB_BYTES,
+              "NodePool chunks must fit in an arena slab");
+static_assert(sizeof(NodePool::Chunk) % alignof(NodePool::Chunk) == 0,
+              "Chunks carved back to back must stay aligned");
+
+static size_t const CHUNKS_PER_SLAB =
+    NodeArena::SLAB_BYTES / sizeof(NodePool::Chunk);
+
+// A thread that holds this many free chunks hands a slab's worth of them to
+// the shared pool, so that chunks released by one thread can be acquired by
+// others.
+static size_t const MAX_LOCAL_FREE_CHUNKS = 2 * CHUNKS_PER_SLAB;
+
+// Slabs are never freed, so only their number is kept. Trivial types here
+// and below stay usable by teams destroyed during static destruction.
+static std::atomic<size_t> n_slabs(0);
+static std::atomic<size_t> n_chunks_in_use(0);
+
+// Free chunks of this thread. Each holds a pointer to the next one, so the
+// list needs no storage of its own and nothing to destroy at thread exit.
+static thread_local void* free_chunks = nullptr;
+static thread_local size_t n_free_chunks = 0;
+
+// Lists of free chunks given up by threads. The first chunk of each list
+// also holds the next list and the length of its own.
+static void* shared_lists = nullptr;
+static std::atomic_flag shared_lists_lock = ATOMIC_FLAG_INIT;
+
+static_assert(sizeof(NodePool::Chunk) >= 3 * sizeof(void*),
+              "Free chunks must fit their list links");
+
+static void*& next_chunk(void* const chunk) {
+    return static_cast<void**>(chunk)[0];
+}
+
+static void*& next_list(void* const chunk) {
+    return static_cast<void**>(chunk)[1];
+}
+
+static size_t& list_size(void* const chunk) {
+    return *reinterpret_cast<size_t*>(&static_cast<void**>(chunk)[2]);
+}
+
+static void lock_shared_lists() {
+    while (shared_lists_lock.test_and_set(std::memory_order_acquire)) {}
+}
+
+static void unlock_shared_lists() {
+    shared_lists_lock.clear(std::memory_order_release);
+}
+
+// Moves the first n of this thread's free chunks to the shared pool.
+static void give_up_free_chunks(size_t const n) {
+    if (n == 0) {
+        return;
+    }
+
+    void* const list = free_chunks;
+    void* last = list;
+    for (size_t i = 1; i < n; ++i) {
+        last = next_chunk(last);
+    }
+    free_chunks = next_chunk(last);
+    n_free_chunks -= n;
+    next_chunk(last) = nullptr;
+    list_size(list) = n;
+
+    lock_shared_lists();
+    next_list(list) = shared_lists;
+    shared_lists = list;
+    unlock_shared_lists();
+}
+
+// Takes one list from the shared pool as this thread's free chunks, which
+// must be empty.
+static bool take_free_chunks() {
+    lock_shared_lists();
+    void* const list = shared_lists;
+    if (list) {
+        shared_lists = next_list(list);
+    }
+    unlock_shared_lists();
+
+    if (not list) {
+        return false;
+    }
+
+    free_chunks = list;
+    n_free_chunks = list_size(list);
+    return true;
+}
+
+// Gives all free chunks of a thread to the shared pool when the thread
+// exits. Constructed on first use by each thread.
+struct FreeChunksReturner {
+    ~FreeChunksReturner() { give_up_free_chunks(n_free_chunks); }
+};
+static thread_local FreeChunksReturner free_chunks_returner;
+
+/* NodeArena */
+/* accessors */
+size_t NodeArena::bytes_in_use() {
+    return n_chunks_in_use.load(std::memory_order_relaxed) *
+           sizeof(NodePool::Chunk);
+}
+
+size_t NodeArena::bytes_reserved() {
+    return n_slabs.load(std::memory_order_relaxed) * SLAB_BYTES;
+}
+
+/* modifiers */
+void* NodeArena::acquire() {
+    (void) &free_chunks_returner;
+
+    if (not free_chunks and not take_free_chunks()) {
+        void* const slab = std::aligned_alloc(SLAB_BYTES, SLAB_BYTES);
+        if (not slab) {
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(slab, SLAB_BYTES, MADV_HUGEPAGE);
+#endif
+        n_slabs.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t i = CHUNKS_PER_SLAB; i-- > 0;) {
+            void* const chunk = static_cast<NodePool::Chunk*>(slab) + i;
+            next_chunk(chunk) = free_chunks;
+            free_chunks = chunk;
+        }
+        n_free_chunks = CHUNKS_PER_SLAB;
+    }
+
+    void* const chunk = free_chunks;
+    free_chunks = next_chunk(chunk);
+    n_free_chunks--;
+    n_chunks_in_use.fetch_add(1, std::memory_order_relaxed);
+    return chunk;
+}
+
+void NodeArena::release(void* const chunk) {
+    (void) &free_chunks_returner;
+
+    next_chunk(chunk) = free_chunks;
+    free_chunks = chunk;
+    n_free_chunks++;
+    n_chunks_in_use.fetch_sub(1, std::memory_order_relaxed);
+
+    if (n_free_chunks >= MAX_LOCAL_FREE_CHUNKS) {
+        give_up_free_chunks(CHUNKS_PER_SLAB);
+    }
+}
+
+/* NodePool */
+/* protected */
+/* modifiers */
+void NodePool::add_chunk() {
+    chunks_.emplace_back(new (NodeArena::acquire()) Chunk());
+}
+
+/* public */
+/* accessors */
+Node* NodePool::get(NodeKey const nk) {
+    size_t const index = nk->index();
+    DEBUG_NOMSG(index >= n_slots_);
+    DEBUG_NOMSG(&*slot(index) != nk);
+    return &*slot(index);
+}
+
+NodeKey NodePool::counterpart(NodeKey const other_nk) const {
+    size_t const index = other_nk->index();
+    DEBUG_NOMSG(index >= n_slots_);
+    DEBUG_NOMSG(not slot(index));
+    return &*slot(index);
+}
+
+void NodePool::write_checkpoint(checkpoint::Writer& writer) const {
+    writer.put<uint64_t>(n_slots_);
+    for (size_t i = 0; i < n_slots_; ++i) {
+        auto const& node = slot(i);
+        writer.put<uint8_t>(bool(node));
+        if (node) {
+            writer.put<uint32_t>(
+                XDB.mod_idx_map().at(node->prototype_->name));
+            writer.put(node->tx_.to_floats());
+        }
+    }
+
+    // Links are written after all nodes, which they refer to.
+    for (size_t i = 0; i < n_slots_; ++i) {
+        if (slot(i)) {
+            writer.put<uint8_t>(slot(i)->links().size());
+            for (auto const& link : slot(i)->links()) {
+                write_term(writer, link.src());
+                write_term(writer, link.dst());
+            }
+        }
+    }
+
+    writer.put_vector<uint64_t>({begin(free_slots_), end(free_slots_)});
+}
+
+void NodePool::write_node(checkpoint::Writer& writer,
+                          NodeKey const nk) const {
+    writer.put<uint64_t>(nk ? nk->index() : UINT64_MAX);
+}
+
+NodeKey NodePool::read_node(checkpoint::Reader& reader) const {
+    uint64_t const index = reader.get<uint64_t>();
+    if (index == UINT64_MAX) {
+        return nullptr;
+    }
+
+    PANIC_IF(index >= n_slots_ or not slot(index),
+             CouldNotParse("Checkpoint refers to a missing node"));
+    return &*slot(index);
+}
+
+void NodePool::write_term(checkpoint::Writer& writer,
+                          FreeTerm const& term) const {
+    write_node(writer, term.node);
+    writer.put<uint64_t>(term.chain_id);
+    writer.put(term.term);
+    writer.put(term.should_restore);
+}
+
+FreeTerm NodePool::read_term(checkpoint::Reader& reader) const {
+    NodeKey const node = read_node(reader);
+    size_t const chain_id = reader.get<uint64_t>();
+    TermType const term = reader.get<TermType>();
+
+    FreeTerm res(node, chain_id, term);
+    res.should_restore = reader.get<bool>();
+    return res;
+}
+
+/* modifiers */
+Node* NodePool::emplace(ProtoModule const* const prototype,
+                        Transform const& tx)
+{
+    size_t index = n_slots_;
+    if (free_slots_.empty()) {
+        if (n_slots_ == chunks_.size() * CHUNK_SIZE) {
+            add_chunk();
+        }
+        n_slots_++;
+    }
+    else {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+    }
+
+    auto& node = slot(index).emplace(prototype, tx);
+    node.index_ = index;
+    size_++;
+
+    return &node;
+}
+
+void NodePool::erase(NodeKey const nk) {
+    size_t const index = nk->index();
+    DEBUG_NOMSG(&*slot(index) != nk);
+
+    slot(index).reset();
+    free_slots_.push_back(index);
+    size_--;
+}
+
+void NodePool::clear() {
+    for (size_t i = 0; i < n_slots_; ++i) {
+        slot(i).reset();
+    }
+
+    free_slots_.clear();
+    n_slots_ = 0;
+    size_ = 0;
+}
+
+void NodePool::copy(NodePool const& other) {
+    if (this == &other) {
+        return;
+    }
+
+    while (chunks_.size() * CHUNK_SIZE < other.n_slots_) {
+        add_chunk();
+    }
+
+    // Slots past other.n_slots_ may hold nodes from before.
+    size_t const n_slots = std::max(n_slots_, other.n_slots_);
+    for (size_t i = 0; i < n_slots; ++i) {
+        if (i < other.n_slots_ and other.slot(i)) {
+            slot(i).emplace(*other.slot(i));
+        }
+        else {
+            slot(i).reset();
+        }
+    }
+
+    free_slots_ = other.free_slots_;
+    n_slots_ = other.n_slots_;
+    size_ = other.size_;
+
+    for (size_t i = 0; i < n_slots_; ++i) {
+        if (slot(i)) {
+            slot(i)->update_link_ptrs(*this);
+        }
+    }
+}
+
+void NodePool::read_checkpoint(checkpoint::Reader& reader) {
+    clear();
+
+    // Each slot takes at least its occupancy byte.
+    n_slots_ = reader.get_length(sizeof(uint8_t));
+    while (chunks_.size() * CHUNK_SIZE < n_slots_) {
+        add_chunk();
+    }
+
+    auto const& all_mods = XDB.all_mods();
+    for (size_t i = 0; i < n_slots_; ++i) {
+        if (reader.get<uint8_t>()) {
+            size_t const mod_idx = reader.get<uint32_t>();
+            PANIC_IF(mod_idx >= all_mods.size(),
+                     CouldNotParse("Checkpoint refers to a missing module"));
+
+            auto const tx = reader.get<Transform::Floats>();
+            auto& node = slot(i).emplace(all_mods[mod_idx].get(), Transform(tx));
+            node.index_ = i;
+            size_++;
+        }
+    }
+
+    for (size_t i = 0; i < n_slots_; ++i) {
+        if (slot(i)) {
+            size_t const n_links = reader.get<uint8_t>();
+            for (size_t j = 0; j < n_links; ++j) {
+                FreeTerm const src = read_term(reader);
+                FreeTerm const dst = read_term(reader);
+                PANIC_IF(not src.node or not dst.node,
+                         CouldNotParse("Checkpoint has a broken link"));
+                ProtoLink const* const pt_link = src.find_link_to(dst);
+                PANIC_IF(not pt_link,
+                         CouldNotParse("Checkpoint has a broken link"));
+                slot(i)->add_link(src, pt_link, dst);
+            }
+        }
+    }
+
+    // emplace() fills free slots blindly, so each must be a distinct empty
+    // slot.
+    auto const free_slots = reader.get_vector<uint64_t>();
+    std::vector<bool> is_free(n_slots_, false);
+    for (auto const index : free_slots) {
+        PANIC_IF(index >= n_slots_ or is_free[index] or slot(index),
+                 CouldNotParse("Checkpoint has a bad free slot"));
+        is_free[index] = true;
+    }
+    free_slots_.assign(begin(free_slots), end(free_slots));
+}
+
+}  /* elfin */
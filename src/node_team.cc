@@ -6,6 +6,7 @@
 #include "path_team.h"
 #include "hinge_team.h"
 #include "double_hinge_team.h"
+#include "checkpoint.h"
 
 namespace elfin {
 
@@ -18,7 +19,7 @@ void NodeTeam::reset() {
 
 /* public */
 /* ctors */
-NodeTeam::NodeTeam(WorkArea const* const wa, uint32_t const seed) :
+NodeTeam::NodeTeam(WorkArea const* const wa, random::Stream const& seed) :
     work_area_(wa),
     seed_(seed)
 {
@@ -26,7 +27,7 @@ NodeTeam::NodeTeam(WorkArea const* const wa, uint32_t const seed) :
 }
 
 NodeTeamSP NodeTeam::create_team(WorkArea const* const work_area,
-                                 uint32_t const seed) {
+                                 random::Stream const& seed) {
     TRACE_NOMSG(not work_area);
 
     NodeTeamSP team_up;
@@ -58,11 +59,21 @@ NodeTeam::NodeTeam(NodeTeam&& other) :
     NodeTeam(other.work_area_, other.seed_)
 { this->operator=(std::move(other)); }
 
+/* accessors */
+void NodeTeam::write_checkpoint(checkpoint::Writer& writer) const {
+    writer.put(seed_);
+    writer.put(collision_penalty_);
+    writer.put(checksum_);
+    writer.put(score_);
+    writer.put<uint64_t>(home_node_);
+}
+
 /* modifiers */
 NodeTeam& NodeTeam::operator=(NodeTeam const& other) {
     DEBUG_NOMSG(work_area_ != other.work_area_);
     checksum_ = other.checksum_;
     score_ = other.score_;
+    collision_penalty_ = other.collision_penalty_;
     return *this;
 }
 
@@ -70,8 +81,16 @@ NodeTeam& NodeTeam::operator=(NodeTeam&& other) {
     DEBUG_NOMSG(work_area_ != other.work_area_);
     std::swap(checksum_, other.checksum_);
     std::swap(score_, other.score_);
+    collision_penalty_ = other.collision_penalty_;
     return *this;
 }
 
+void NodeTeam::read_checkpoint(checkpoint::Reader& reader) {
+    seed_ = reader.get<random::Stream>();
+    collision_penalty_ = reader.get<float>();
+    checksum_ = reader.get<Crc32>();
+    score_ = reader.get<float>();
+    home_node_ = reader.get<uint64_t>();
+}
 
 }  /* elfin */
\ No newline at end of file
@@ -59,10 +59,16 @@ struct OutputManager::PImpl : public PImplBase<OutputManager> {
             output_json = JSON(); // Reset output data.
             output_json["exporter"] = "elfin-solver";
             JSON pg_networks = JSON();
+            JSON mutation_stats = JSON();
             for (auto const& wp : spec.work_packages()) {
                 auto const& wp_name = wp->name;
                 auto const wp_name_c = wp_name.c_str();
 
+                for (auto const wa : wp->work_area_keys()) {
+                    mutation_stats[wp_name][wa->name] =
+                        wa->mutation_stats().to_json();
+                }
+
                 for (auto& [wp_dec_name, solutions] : wp->make_solution_map()) {
                     auto const wp_dec_name_c = wp_dec_name.c_str();
 
@@ -95,6 +101,7 @@ struct OutputManager::PImpl : public PImplBase<OutputManager> {
                 }
             }
             output_json["pg_networks"] = pg_networks;
+            output_json["mutation_stats"] = mutation_stats;
         } catch (JSON::exception const& je) {
             JSON_LOG_EXIT(je);
         }
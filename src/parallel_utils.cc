@@ -1,11 +1,285 @@
 #include "parallel_utils.h"
 
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <sched.h>
+
 #include "input_manager.h"
 
 namespace elfin {
 
 namespace parallel {
 
+// Chunks dealt to each thread. More balance better, fewer cost less locking.
+static size_t const CHUNKS_PER_THREAD = 8;
+
+typedef std::pair<size_t, size_t> Chunk;  // [first, last)
+
+// Own cache line each, so that threads locking their own deques do not
+// contend.
+struct alignas(64) ChunkDeque {
+    std::mutex mutex;
+    std::deque<Chunk> chunks;
+
+    bool pop_front(Chunk& chunk) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunks.empty()) return false;
+        chunk = chunks.front();
+        chunks.pop_front();
+        return true;
+    }
+
+    bool pop_back(Chunk& chunk) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunks.empty()) return false;
+        chunk = chunks.back();
+        chunks.pop_back();
+        return true;
+    }
+};
+
+// Node of each CPU, -1 for CPUs this process may not run on. Read once by
+// init().
+static std::vector<int> cpu_nodes;
+static std::vector<cpu_set_t> node_cpu_sets;
+
+// CPU ids of a sysfs list such as "0-3,8,10-11".
+static std::vector<int> parse_cpu_list(std::string const& list) {
+    std::vector<int> res;
+    std::istringstream iss(list);
+    std::string range;
+    while (std::getline(iss, range, ',')) {
+        if (range.empty()) continue;
+        size_t const dash_idx = range.find('-');
+        int const first = std::stoi(range.substr(0, dash_idx));
+        int const last = dash_idx == std::string::npos ?
+                         first :
+                         std::stoi(range.substr(dash_idx + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            res.push_back(cpu);
+        }
+    }
+    return res;
+}
+
+static std::string read_line(std::string const& path) {
+    std::ifstream ifs(path);
+    std::string line;
+    std::getline(ifs, line);
+    return line;
+}
+
+static void read_topology() {
+    cpu_nodes.assign(CPU_SETSIZE, -1);
+    node_cpu_sets.clear();
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    std::string const node_dir = "/sys/devices/system/node/";
+    for (int const node : parse_cpu_list(read_line(node_dir + "online"))) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        std::string const cpu_list = read_line(
+            node_dir + "node" + std::to_string(node) + "/cpulist");
+        for (int const cpu : parse_cpu_list(cpu_list)) {
+            if (cpu < CPU_SETSIZE and CPU_ISSET(cpu, &allowed)) {
+                CPU_SET(cpu, &cpu_set);
+                cpu_nodes[cpu] = node_cpu_sets.size();
+            }
+        }
+
+        // Nodes with memory only have nothing to run on.
+        if (CPU_COUNT(&cpu_set) > 0) {
+            node_cpu_sets.push_back(cpu_set);
+        }
+    }
+
+    if (node_cpu_sets.empty()) {
+        node_cpu_sets.push_back(allowed);
+        std::fill(begin(cpu_nodes), end(cpu_nodes), 0);
+    }
+}
+
+// Pins consecutive blocks of threads to the same node, the way run_tasks()
+// deals out chunks. Threads are free to move within their node.
+static void pin_threads() {
+    size_t const n_node_sets = node_cpu_sets.size();
+
+    #pragma omp parallel
+    {
+        size_t const tid = omp_get_thread_num();
+        size_t const node = tid * n_node_sets / omp_get_num_threads();
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &node_cpu_sets[node])) {
+            JUtil.warn("Could not pin thread #%zu to NUMA node %zu\n",
+                       tid, node);
+        }
+    }
+
+    JUtil.info("Pinned %d threads to %zu NUMA nodes\n",
+               omp_get_max_threads(), n_node_sets);
+}
+
+/* ThreadTimes */
+/* accessors */
+double ThreadTimes::mean_idle_ms() const {
+    if (busy_ms.empty()) return 0;
+    double const total_busy =
+        std::accumulate(begin(busy_ms), end(busy_ms), 0.0);
+    return wall_ms - total_busy / busy_ms.size();
+}
+
+double ThreadTimes::max_idle_ms() const {
+    if (busy_ms.empty()) return 0;
+    return wall_ms - *std::min_element(begin(busy_ms), end(busy_ms));
+}
+
+void ThreadTimes::print(char const* section_name) const {
+    JUtil.info("Section (%s) idle time: mean %.1fms, max %.1fms "
+               "of %.1fms on %zu threads; %zu steals\n",
+               section_name,
+               mean_idle_ms(),
+               max_idle_ms(),
+               wall_ms,
+               busy_ms.size(),
+               steals);
+}
+
+/* free functions */
+// Cuts [0, n) into chunks of about equal cost, in order, each with the
+// one of n_threads it is dealt to. Shared by run_tasks() and task_nodes().
+static std::vector<std::pair<Chunk, size_t>> split_tasks(
+    size_t const n,
+    std::function<float(size_t)> const& cost,
+    size_t const n_threads) {
+    // Each task counts as at least a tiny bit, so that a run of zero cost
+    // tasks is still split up.
+    std::vector<double> costs(n);
+    double total_cost = 0;
+    for (size_t i = 0; i < n; ++i) {
+        costs[i] = std::max(cost(i), 1e-3f);
+        total_cost += costs[i];
+    }
+
+    std::vector<std::pair<Chunk, size_t>> res;
+    double const chunk_cost = total_cost / (n_threads * CHUNKS_PER_THREAD);
+    double const thread_cost = total_cost / n_threads;
+    double done_cost = 0, chunk_start_cost = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < n; ++i) {
+        done_cost += costs[i];
+        if (done_cost - chunk_start_cost >= chunk_cost or i + 1 == n) {
+            // Neighbouring chunks go to the same thread.
+            double const mid_cost = (chunk_start_cost + done_cost) / 2;
+            size_t const owner = std::min(n_threads - 1,
+                                          (size_t) (mid_cost / thread_cost));
+            res.emplace_back(Chunk(first, i + 1), owner);
+            first = i + 1;
+            chunk_start_cost = done_cost;
+        }
+    }
+
+    return res;
+}
+
+ThreadTimes run_tasks(size_t const n,
+                      std::function<float(size_t)> const& cost,
+                      std::function<void(size_t)> const& task) {
+    size_t const n_threads = std::max(1, omp_get_max_threads());
+
+    ThreadTimes res;
+    res.busy_ms.resize(n_threads, 0);
+    if (n == 0) return res;
+
+    std::unique_ptr<ChunkDeque[]> deques(new ChunkDeque[n_threads]);
+    for (auto const& [chunk, owner] : split_tasks(n, cost, n_threads)) {
+        deques[owner].chunks.push_back(chunk);
+    }
+
+    std::atomic<size_t> steals(0);
+    std::vector<size_t> thread_nodes(n_threads, SIZE_MAX);
+    size_t n_team = n_threads;
+    double const start_time = JUtil.get_timestamp_us();
+
+    #pragma omp parallel num_threads(n_threads)
+    {
+        size_t const tid = omp_get_thread_num();
+        double busy_us = 0;
+
+        // The team can be smaller than asked for, so every deque is looked
+        // at.
+        #pragma omp master
+        n_team = omp_get_num_threads();
+
+        // Victims on the same node are stolen from first.
+        size_t const node = this_node();
+        thread_nodes[tid] = node;
+        #pragma omp barrier
+
+        Chunk chunk;
+        while (true) {
+            bool found = deques[tid].pop_front(chunk);
+            if (not found) {
+                for (bool const local : {true, false}) {
+                    for (size_t i = 1; not found and i < n_threads; ++i) {
+                        size_t const victim = (tid + i) % n_threads;
+                        if ((thread_nodes[victim] == node) == local) {
+                            found = deques[victim].pop_back(chunk);
+                        }
+                    }
+                }
+                if (found) steals++;
+            }
+
+            // No task makes more tasks, so all deques stay empty.
+            if (not found) break;
+
+            double const chunk_start_time = JUtil.get_timestamp_us();
+            for (size_t i = chunk.first; i < chunk.second; ++i) {
+                task(i);
+            }
+            busy_us += JUtil.get_timestamp_us() - chunk_start_time;
+        }
+
+        res.busy_ms[tid] = busy_us / 1e3;
+    }
+
+    res.wall_ms = (JUtil.get_timestamp_us() - start_time) / 1e3;
+    res.busy_ms.resize(n_team);
+    res.steals = steals;
+
+    return res;
+}
+
+std::vector<size_t> task_nodes(size_t const n,
+                               std::function<float(size_t)> const& cost) {
+    // Split among nodes as if each had one thread, so that the number of
+    // threads does not matter.
+    std::vector<size_t> res(n);
+    for (auto const& [chunk, node] : split_tasks(n, cost, n_nodes())) {
+        std::fill(begin(res) + chunk.first, begin(res) + chunk.second, node);
+    }
+
+    return res;
+}
+
+size_t n_nodes() {
+    return std::max((size_t) 1, node_cpu_sets.size());
+}
+
+size_t this_node() {
+    int const cpu = sched_getcpu();
+    return cpu >= 0 and cpu < (int) cpu_nodes.size() and cpu_nodes[cpu] >= 0 ?
+           cpu_nodes[cpu] : 0;
+}
+
 void init() {
     // Explicitly disable dynamic thread teams
     omp_set_dynamic(0);
@@ -17,6 +291,11 @@ void init() {
         JUtil.info("Using %zu threads\n", OPTIONS.n_workers);
         omp_set_num_threads(OPTIONS.n_workers);
     }
+
+    read_topology();
+    if (OPTIONS.pin_threads) {
+        pin_threads();
+    }
 }
 
 }  /* parallel */
@@ -0,0 +1,115 @@
+#include "parallel_utils.h"
+
+#include <atomic>
+#include <memory>
+
+#include "test_stat.h"
+
+namespace elfin {
+
+namespace parallel {
+
+/* tests */
+TestStat test() {
+    TestStat ts;
+
+    size_t const N = 10007;
+
+    // Every task runs exactly once, however uneven the costs and whatever
+    // the number of threads. Later tests get the threads they had.
+    int const max_threads = omp_get_max_threads();
+    for (int const n_threads : {1, 3, 8}) {
+        omp_set_num_threads(n_threads);
+
+        std::unique_ptr<std::atomic<size_t>[]> runs(
+            new std::atomic<size_t>[N]);
+        for (size_t i = 0; i < N; ++i) {
+            runs[i] = 0;
+        }
+
+        auto const times = run_tasks(
+                               N,
+        [](size_t const i) { return i % 97 == 0 ? 1000.0f : 1.0f; },
+        [&](size_t const i) { runs[i]++; });
+
+        ts.tests++;
+        for (size_t i = 0; i < N; ++i) {
+            if (runs[i] != 1) {
+                ts.errors++;
+                JUtil.error("Task #%zu ran %zu times on %d threads\n",
+                            i, runs[i].load(), n_threads);
+                break;
+            }
+        }
+
+        ts.tests++;
+        if (times.busy_ms.size() > (size_t) n_threads or
+                times.max_idle_ms() < 0 or
+                times.mean_idle_ms() > times.max_idle_ms()) {
+            ts.errors++;
+            JUtil.error("Bad thread times on %d threads\n", n_threads);
+        }
+    }
+    omp_set_num_threads(max_threads);
+
+    // Every thread runs on a known node.
+    {
+        ts.tests++;
+        std::atomic<size_t> n_bad(0);
+        #pragma omp parallel
+        if (this_node() >= n_nodes()) {
+            n_bad++;
+        }
+        if (n_bad) {
+            ts.errors++;
+            JUtil.error("%zu threads are on nodes past %zu\n",
+                        n_bad.load(), n_nodes());
+        }
+    }
+
+    // Tasks are placed on nodes in order, within range, whatever the number
+    // of threads.
+    {
+        auto const cost = [](size_t const i) {
+            return i < N / 2 ? 1.0f : 100.0f;
+        };
+        auto const nodes = task_nodes(N, cost);
+
+        ts.tests++;
+        bool ok = nodes.size() == N;
+        for (size_t i = 0; ok and i < N; ++i) {
+            ok = nodes[i] < n_nodes() and (i == 0 or nodes[i - 1] <= nodes[i]);
+        }
+        if (not ok) {
+            ts.errors++;
+            JUtil.error("Bad task nodes on %zu nodes\n", n_nodes());
+        }
+
+        ts.tests++;
+        omp_set_num_threads(3);
+        if (task_nodes(N, cost) != nodes) {
+            ts.errors++;
+            JUtil.error("Task nodes changed with the number of threads\n");
+        }
+        omp_set_num_threads(max_threads);
+    }
+
+    // Nothing to do runs nothing.
+    {
+        ts.tests++;
+        size_t n_runs = 0;
+        run_tasks(0,
+        [](size_t) { return 1.0f; },
+        [&](size_t) { n_runs++; });
+        if (n_runs != 0) {
+            ts.errors++;
+            JUtil.error("Empty run_tasks() ran %zu tasks\n", n_runs);
+        }
+    }
+
+    return ts;
+}
+
+}  /* parallel */
+
+}  /* elfin */
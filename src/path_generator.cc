@@ -82,11 +82,17 @@ std::vector<LinkCPtr> PathGenerator::collect_arrows()
 }
 
 V3fList PathGenerator::collect_points() {
-    return collect(
-               CollectFunc<Vector3f>(
-    [](NodeKey const nk, LinkCPtr link) {
-        return nk->tx_.collapsed();
-    }));
+    V3fList res;
+    collect_points(res);
+    return res;
+}
+
+void PathGenerator::collect_points(V3fList& points) {
+    DEBUG_NOMSG(curr_node_);  // At a proper start, curr_node_ is nullptr.
+    points.clear();
+    while (not is_done()) {
+        points.emplace_back(next()->tx_.collapsed());
+    }
 }
 
 std::vector<NodeKey> PathGenerator::collect_keys(size_t skip) {
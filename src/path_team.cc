@@ -1,11 +1,15 @@
 #include "path_team.h"
 
+#include <chrono>
+
 #include "scoring.h"
+#include "collision.h"
 #include "path_generator.h"
 #include "input_manager.h"
 #include "id_types.h"
 #include "mutation.h"
 #include "priv_impl.h"
+#include "checkpoint.h"
 
 namespace elfin {
 
@@ -53,8 +57,7 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
     }
 
     Node* get_node(NodeKey const nk) {
-        DEBUG_NOMSG(_.nodes_.find(nk) == end(_.nodes_));
-        return _.nodes_.at(nk).get();
+        return _.mutable_nodes().get(nk);
     }
 
     void nip_tip(NodeKey tip_node)
@@ -78,18 +81,20 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
         // Remove tip node. Don't do this before restoring the FreeTerm
         // unless new_free_term is a copy rather than a reference.
         _.remove_free_terms(tip_node);
-        _.nodes_.erase(tip_node);
+        _.mutable_nodes().erase(tip_node);
     }
 
-    void build_bridge(mutation::InsertPoint const& insert_point,
-                      FreeTerm::Bridge const* bridge = nullptr)
+    void build_bridge(mutation::InsertPoint const& insert_point)
     {
-        if (not bridge) {
-            bridge = &random::pick(insert_point.bridges, _.seed_);
-        }
+        build_bridge(insert_point.src,
+                     insert_point.dst,
+                     random::pick(insert_point.bridges, _.seed_));
+    }
 
-        FreeTerm const& port1 = insert_point.src;
-        FreeTerm const& port2 = insert_point.dst;
+    void build_bridge(FreeTerm const& port1,
+                      FreeTerm const& port2,
+                      FreeTerm::Bridge const& bridge)
+    {
         auto node1 = get_node(port1.node);
         auto node2 = get_node(port2.node);
 
@@ -98,8 +103,8 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
         node2->remove_link(port2);
 
         // Create a new node in the middle.
-        auto new_node_key = _.add_node(bridge->pt_link1->module,
-                                       node1->tx_ * bridge->pt_link1->tx,
+        auto new_node_key = _.add_node(bridge.pt_link1->module,
+                                       node1->tx_ * bridge.pt_link1->tx,
                                        /*innert=*/true);
         auto new_node = get_node(new_node_key);
 
@@ -116,15 +121,15 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
         // Prototype ---pt_link1--->              ---pt_link2--->
         //
         FreeTerm nn_src1(
-            new_node_key, bridge->pt_link1->chain_id, port2.term);
-        Link const new_link1_rev(port1, bridge->pt_link1, nn_src1);
+            new_node_key, bridge.pt_link1->chain_id, port2.term);
+        Link const new_link1_rev(port1, bridge.pt_link1, nn_src1);
 
         node1->add_link(new_link1_rev);
         new_node->add_link(new_link1_rev.reversed());
 
         FreeTerm nn_src2(
-            new_node_key, bridge->pt_link2->reverse->chain_id, port1.term);
-        Link const new_link2(nn_src2, bridge->pt_link2, port2);
+            new_node_key, bridge.pt_link2->reverse->chain_id, port1.term);
+        Link const new_link2(nn_src2, bridge.pt_link2, port2);
 
         new_node->add_link(new_link2);
         node2->add_link(new_link2.reversed());
@@ -141,7 +146,7 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
         PathGenerator pg(start_node_key);
         while (not pg.is_done()) {
             auto next_key = pg.next();
-            _.nodes_.erase(next_key);
+            _.mutable_nodes().erase(next_key);
         }
 
         _.remove_free_terms(pg.curr_node());
@@ -195,201 +200,82 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
         }
     }
 
-    /* mutation methods */
-    bool erode_mutate()
+    /* mutation points */
+    // Walks through all nodes to collect delete points.
+    std::vector<mutation::DeletePoint> collect_delete_points()
     {
-        bool mutate_success = false;
-
-        if (_.size() > 1) {
-            // Pick random tip node if not specified.
-            NodeKey tip_node = _.get_tip(/*mutable_hint=*/true);
-            _.remove_free_terms(tip_node);
-
-            FreeTerm last_free_term;
-            float p = 1.0f;  // p for Probability.
-
-            // Loop condition is always true on first entrance, hence do-while.
-            bool next_loop = false;
-            size_t const original_size = _.size();
-            do {
-                // Calculate next iteration condition - linearly falling
-                // probability.
-                p = (_.size() - 1) / original_size;
-                next_loop = random::get_dice_0to1(_.seed_) <= p;
-
-                // Check node is tip node.
-                size_t const num_links = tip_node->links().size();
-                TRACE(num_links != 1, "num_links=%zu", num_links);
-
-                FreeTerm const& new_free_term =
-                    begin(tip_node->links())->dst();
-                NodeKey new_tip = new_free_term.node;
-
-                // Unlink
-                get_node(new_tip)->remove_link(new_free_term);
-
-                if (not next_loop) {
-                    last_free_term = new_free_term;
-                }
-
-                _.nodes_.erase(tip_node);
-
-                tip_node = new_tip;
-            } while (next_loop);
-
-            // Restore chain.
-            if (last_free_term.should_restore) {
-                _.free_terms_.push_back(last_free_term);
-            }
-
-            regenerate();
+        std::vector<mutation::DeletePoint> delete_points;
 
-            mutate_success = true;
-        }
-
-        return mutate_success;
-    }
-
-    bool delete_mutate()
-    {
-        bool mutate_success = false;
-
-        if (_.size() > 1) {
-            // Walk through all nodes to collect delete points.
-            std::vector<mutation::DeletePoint> delete_points;
-
-            // Starting at either end is fine.
-            auto start_node = begin(_.free_terms_)->node;
-            PathGenerator path_gen(start_node);
-
-            NodeKey curr_node = nullptr;
-            auto next_node = path_gen.next();  // Starts with start_node.
-            do {
-                curr_node = next_node;
-                next_node = path_gen.next();  // Can be nullptr.
-                size_t const num_links = curr_node->links().size();
-
-                if (num_links == 1) {
-                    if ( _.is_mutable(curr_node)) {
-                        //
-                        // curr_node is a tip node, which can always be deleted trivially.
-                        // Use ProtoLink* = nullptr to mark a tip node. Pointers
-                        // src and dst are not used.
-                        //
-                        delete_points.emplace_back(
-                            /*delete_node=*/ curr_node,
-                            /*src=*/ FreeTerm(),
-                            /*dst=*/ FreeTerm(),
-                            /*skipper=*/ nullptr);
-                    }
-                }
-                else if (num_links == 2) {
-                    //
-                    // curr_node is between start and end node. Find a link that
-                    // skips curr_node. The reverse doesn't need to be checked,
-                    // because all links have a reverse.
-                    //
+        // Starting at either end is fine.
+        auto start_node = begin(_.free_terms_)->node;
+        PathGenerator path_gen(start_node);
 
-                    auto itr = begin(curr_node->links());
-                    Link const& link1 = *itr;
-                    advance(itr, 1);
-                    Link const& link2 = *itr;
-                    FreeTerm const& src = link1.dst();
-                    FreeTerm const& dst = link2.dst();
+        NodeKey curr_node = nullptr;
+        auto next_node = path_gen.next();  // Starts with start_node.
+        do {
+            curr_node = next_node;
+            next_node = path_gen.next();  // Can be nullptr.
+            size_t const num_links = curr_node->links().size();
 
+            if (num_links == 1) {
+                if ( _.is_mutable(curr_node)) {
                     //
-                    // X--[neighbor1]--src->-<-dst               dst->-<-src--[neighbor2]--...
-                    //                 (  link1  )               (  link2  )
-                    //                 vvvvvvvvvvv               vvvvvvvvvvv
-                    //                 dst->-<-src--[curr_node]--src->-<-dst
-                    //                 ^^^                               ^^^
-                    //                (src)                             (dst)
+                    // curr_node is a tip node, which can always be deleted trivially.
+                    // Use ProtoLink* = nullptr to mark a tip node. Pointers
+                    // src and dst are not used.
                     //
-                    ProtoLink const* const proto_link_ptr =
-                        src.find_link_to(dst);
-                    if (proto_link_ptr) {
-                        delete_points.emplace_back(
-                            /*delete_node=*/ curr_node,
-                            /*src=*/ src,
-                            /*dst=*/ dst,
-                            /*skipper=*/ proto_link_ptr);
-                    }
+                    delete_points.emplace_back(
+                        /*delete_node=*/ curr_node,
+                        /*src=*/ FreeTerm(),
+                        /*dst=*/ FreeTerm(),
+                        /*skipper=*/ nullptr);
                 }
-                else {
-                    TRACE("Unexpected num_links",
-                          "num_links=%zu\n",
-                          num_links);
-                }
-            } while (not path_gen.is_done());
-
-            // delete_points might be empty (if HingeTeam has no other nodes
-            // than hinge_).
-            if (not delete_points.empty()) {
-                // Delete a node using a random deletable point.
-                auto const& delete_point = random::pick(delete_points, _.seed_);
-                if (delete_point.skipper) {
-                    //
-                    // This is NOT a tip node. Need to do some clean up
-                    //
-                    // Link up neighbor1 and neighbor2
-                    // X--[neighbor1]--src->-<-dst                 dst->-<-src--[neighbor2]--...
-                    //                 (  link1  )                 (  link2  )
-                    //                 vvvvvvvvvvv                 vvvvvvvvvvv
-                    //                 dst->-<-src--[delete_node]--src->-<-dst
-                    //                 ^^^                                 ^^^
-                    //                (src)                               (dst)
-                    //
-                    auto neighbor1 = get_node(delete_point.src.node);
-                    auto neighbor2 = get_node(delete_point.dst.node);
-
-                    neighbor1->remove_link(delete_point.src);
-                    neighbor2->remove_link(delete_point.dst);
-                    //
-                    // X--[neighbor1]--X                                     X--[neighbor2]--...
-                    //                 (  link1  )                 (  link2  )
-                    //                 vvvvvvvvvvv                 vvvvvvvvvvv
-                    //                 dst->-<-src--[delete_node]--src->-<-dst
-                    //                 ----------------arrow1---------------->
-                    //
-
-                    // Create links between neighbor1 and neighbor2.
-                    Link const arrow1(delete_point.src,
-                                      delete_point.skipper,
-                                      delete_point.dst);
-                    neighbor1->add_link(arrow1);
-                    neighbor2->add_link(arrow1.reversed());
-                    //
-                    //         link1->dst     link2->dst
-                    //                  vvv     vvv
-                    //  X--[neighbor1]--src->-<-dst
-                    //                  dst->-<-src--[neighbor2]--...
-                    //                  ^^^     ^^^
-                    //         link1->dst     link2->dst
-                    //
+            }
+            else if (num_links == 2) {
+                //
+                // curr_node is between start and end node. Find a link that
+                // skips curr_node. The reverse doesn't need to be checked,
+                // because all links have a reverse.
+                //
 
-                    _.nodes_.erase(delete_point.delete_node);
+                auto itr = begin(curr_node->links());
+                Link const& link1 = *itr;
+                advance(itr, 1);
+                Link const& link2 = *itr;
+                FreeTerm const& src = link1.dst();
+                FreeTerm const& dst = link2.dst();
 
-                    // delete_node is guranteed to not be a tip so no need to clean up
-                    // _.free_terms_.
-                    _.fix_limb_transforms(arrow1);
-                }
-                else {
-                    // This is a tip node.
-                    nip_tip(delete_point.delete_node);
+                //
+                // X--[neighbor1]--src->-<-dst               dst->-<-src--[neighbor2]--...
+                //                 (  link1  )               (  link2  )
+                //                 vvvvvvvvvvv               vvvvvvvvvvv
+                //                 dst->-<-src--[curr_node]--src->-<-dst
+                //                 ^^^                               ^^^
+                //                (src)                             (dst)
+                //
+                ProtoLink const* const proto_link_ptr =
+                    src.find_link_to(dst);
+                if (proto_link_ptr) {
+                    delete_points.emplace_back(
+                        /*delete_node=*/ curr_node,
+                        /*src=*/ src,
+                        /*dst=*/ dst,
+                        /*skipper=*/ proto_link_ptr);
                 }
-
-                mutate_success = true;
             }
-        }
+            else {
+                TRACE("Unexpected num_links",
+                      "num_links=%zu\n",
+                      num_links);
+            }
+        } while (not path_gen.is_done());
 
-        return mutate_success;
+        return delete_points;
     }
 
-    bool insert_mutate()
+    // Walks through all links to collect insert points.
+    std::vector<mutation::InsertPoint> collect_insert_points()
     {
-        bool mutate_success = false;
-
-        // Walk through all links to collect insert points.
         std::vector<mutation::InsertPoint> insert_points;
 
         auto start_node = _.get_tip(/*mutable_hint=*/false);
@@ -440,50 +326,12 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
             }
         } while (not path_gen.is_done());
 
-        // insert_points might be empty (if HingeTeam has no other nodes
-        // than hinge_).
-        if (not insert_points.empty()) {
-            // Insert a node using a random insert point
-            auto const& insert_point = random::pick(insert_points, _.seed_);
-            if (insert_point.dst.node) {
-                // This is a non-tip node.
-                build_bridge(insert_point);
-            }
-            else {
-                // This is a tip node. Inserting is the same as grow_tip().
-                auto ft_itr = find_if(begin(_.free_terms_),
-                                      end(_.free_terms_),
-                [&](auto const & ft) {
-                    return ft.node == insert_point.src.node;
-                });
-
-                if (ft_itr == end(_.free_terms_)) {
-                    std::ostringstream oss;
-                    oss << "FreeTerm not found for ";
-                    oss << *insert_point.src.node << "\n";
-
-                    oss << "Available FreeTerm(s):\n";
-                    for (auto const& ft : _.free_terms_) {
-                        oss << ft << "\n";
-                    }
-                    throw ValueNotFound(oss.str());
-                }
-                else {
-                    _.grow_tip(*ft_itr);
-                }
-            }
-
-            mutate_success = true;
-        }
-
-        return mutate_success;
+        return insert_points;
     }
 
-    bool swap_mutate()
+    // Walks through all links to collect swap points.
+    std::vector<mutation::SwapPoint> collect_swap_points()
     {
-        bool mutate_success = false;
-
-        // Walk through all links to collect swap points.
         std::vector<mutation::SwapPoint> swap_points;
 
         auto start_node = _.get_tip(/*mutable_hint=*/false);
@@ -545,6 +393,193 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
             }
         } while (not path_gen.is_done());
 
+        return swap_points;
+    }
+
+    // The free term on tip_node.
+    FreeTerm const& tip_free_term(NodeKey const tip_node) const
+    {
+        auto ft_itr = find_if(begin(_.free_terms_),
+                              end(_.free_terms_),
+        [&](auto const & ft) {
+            return ft.node == tip_node;
+        });
+
+        if (ft_itr == end(_.free_terms_)) {
+            std::ostringstream oss;
+            oss << "FreeTerm not found for ";
+            oss << *tip_node << "\n";
+
+            oss << "Available FreeTerm(s):\n";
+            for (auto const& ft : _.free_terms_) {
+                oss << ft << "\n";
+            }
+            throw ValueNotFound(oss.str());
+        }
+
+        return *ft_itr;
+    }
+
+    void delete_at(mutation::DeletePoint const& delete_point)
+    {
+        if (delete_point.skipper) {
+            //
+            // This is NOT a tip node. Need to do some clean up
+            //
+            // Link up neighbor1 and neighbor2
+            // X--[neighbor1]--src->-<-dst                 dst->-<-src--[neighbor2]--...
+            //                 (  link1  )                 (  link2  )
+            //                 vvvvvvvvvvv                 vvvvvvvvvvv
+            //                 dst->-<-src--[delete_node]--src->-<-dst
+            //                 ^^^                                 ^^^
+            //                (src)                               (dst)
+            //
+            auto neighbor1 = get_node(delete_point.src.node);
+            auto neighbor2 = get_node(delete_point.dst.node);
+
+            neighbor1->remove_link(delete_point.src);
+            neighbor2->remove_link(delete_point.dst);
+            //
+            // X--[neighbor1]--X                                     X--[neighbor2]--...
+            //                 (  link1  )                 (  link2  )
+            //                 vvvvvvvvvvv                 vvvvvvvvvvv
+            //                 dst->-<-src--[delete_node]--src->-<-dst
+            //                 ----------------arrow1---------------->
+            //
+
+            // Create links between neighbor1 and neighbor2.
+            Link const arrow1(delete_point.src,
+                              delete_point.skipper,
+                              delete_point.dst);
+            neighbor1->add_link(arrow1);
+            neighbor2->add_link(arrow1.reversed());
+            //
+            //         link1->dst     link2->dst
+            //                  vvv     vvv
+            //  X--[neighbor1]--src->-<-dst
+            //                  dst->-<-src--[neighbor2]--...
+            //                  ^^^     ^^^
+            //         link1->dst     link2->dst
+            //
+
+            _.mutable_nodes().erase(delete_point.delete_node);
+
+            // delete_node is guranteed to not be a tip so no need to clean up
+            // _.free_terms_.
+            _.fix_limb_transforms(arrow1);
+        }
+        else {
+            // This is a tip node.
+            nip_tip(delete_point.delete_node);
+        }
+    }
+
+    /* mutation methods */
+    bool erode_mutate()
+    {
+        bool mutate_success = false;
+
+        if (_.size() > 1) {
+            // Pick random tip node if not specified.
+            NodeKey tip_node = _.get_tip(/*mutable_hint=*/true);
+            _.remove_free_terms(tip_node);
+
+            FreeTerm last_free_term;
+            float p = 1.0f;  // p for Probability.
+
+            // Loop condition is always true on first entrance, hence do-while.
+            bool next_loop = false;
+            size_t const original_size = _.size();
+            do {
+                // Calculate next iteration condition - linearly falling
+                // probability.
+                p = (_.size() - 1) / original_size;
+                next_loop = random::get_dice_0to1(_.seed_) <= p;
+
+                // Check node is tip node.
+                size_t const num_links = tip_node->links().size();
+                TRACE(num_links != 1, "num_links=%zu", num_links);
+
+                FreeTerm const& new_free_term =
+                    begin(tip_node->links())->dst();
+                NodeKey new_tip = new_free_term.node;
+
+                // Unlink
+                get_node(new_tip)->remove_link(new_free_term);
+
+                if (not next_loop) {
+                    last_free_term = new_free_term;
+                }
+
+                _.mutable_nodes().erase(tip_node);
+
+                tip_node = new_tip;
+            } while (next_loop);
+
+            // Restore chain.
+            if (last_free_term.should_restore) {
+                _.free_terms_.push_back(last_free_term);
+            }
+
+            regenerate();
+
+            mutate_success = true;
+        }
+
+        return mutate_success;
+    }
+
+    bool delete_mutate()
+    {
+        bool mutate_success = false;
+
+        if (_.size() > 1) {
+            auto const delete_points = collect_delete_points();
+
+            // delete_points might be empty (if HingeTeam has no other nodes
+            // than hinge_).
+            if (not delete_points.empty()) {
+                // Delete a node using a random deletable point.
+                delete_at(random::pick(delete_points, _.seed_));
+                mutate_success = true;
+            }
+        }
+
+        return mutate_success;
+    }
+
+    bool insert_mutate()
+    {
+        bool mutate_success = false;
+
+        auto const insert_points = collect_insert_points();
+
+        // insert_points might be empty (if HingeTeam has no other nodes
+        // than hinge_).
+        if (not insert_points.empty()) {
+            // Insert a node using a random insert point
+            auto const& insert_point = random::pick(insert_points, _.seed_);
+            if (insert_point.dst.node) {
+                // This is a non-tip node.
+                build_bridge(insert_point);
+            }
+            else {
+                // This is a tip node. Inserting is the same as grow_tip().
+                _.grow_tip(tip_free_term(insert_point.src.node));
+            }
+
+            mutate_success = true;
+        }
+
+        return mutate_success;
+    }
+
+    bool swap_mutate()
+    {
+        bool mutate_success = false;
+
+        auto const swap_points = collect_swap_points();
+
         // swap_points may not even contain tip nodes if they can't possibly
         // be swapped.
         if (not swap_points.empty()) {
@@ -552,7 +587,7 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
             auto const& swap_point = random::pick(swap_points, _.seed_);
             if (swap_point.dst.node) {
                 // This is a non-tip node.
-                _.nodes_.erase(swap_point.del_node);
+                _.mutable_nodes().erase(swap_point.del_node);
                 build_bridge(swap_point);
             }
             else {
@@ -619,7 +654,7 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
     }
 
     bool regenerate() {
-        if (_.nodes_.empty()) {
+        if (_.nodes_->empty()) {
             // Pick random initial member.
             _.add_node(XDB.basic_mods().draw(_.seed_));
         }
@@ -636,6 +671,170 @@ struct PathTeam::PImpl : public PImplBase<PathTeam> {
         regenerate();
         _.mutation_invariance_check();
     }
+
+    /* local search */
+    // One neighbor of a team: a delete, insert or swap at a point collected
+    // on the team, using the bridge or ProtoLink numbered choice there.
+    struct Move {
+        mutation::Mode mode;
+        size_t point;
+        size_t choice;
+    };
+
+    // Links that grow_tip() may draw on free_term, less those to current.
+    static std::vector<ProtoLink const*> growable_links(
+        FreeTerm const& free_term,
+        ProtoModule const* const current = nullptr)
+    {
+        std::vector<ProtoLink const*> res;
+        for (auto const& link : free_term.get_ptterm().links()) {
+            if (link->get_term().is_active() and link->module != current) {
+                res.push_back(link.get());
+            }
+        }
+        return res;
+    }
+
+    // Carries out move on this team, given the points collected on the team
+    // that this one copied its nodes from and then unshared.
+    void apply(Move const& move,
+               std::vector<mutation::DeletePoint> const& delete_points,
+               std::vector<mutation::InsertPoint> const& insert_points,
+               std::vector<mutation::SwapPoint> const& swap_points)
+    {
+        auto const moved_node = [&](NodeKey const nk) {
+            return _.nodes_->counterpart(nk);
+        };
+        auto const moved = [&](FreeTerm ft) {
+            if (ft.node) {
+                ft.node = moved_node(ft.node);
+            }
+            return ft;
+        };
+
+        switch (move.mode) {
+        case mutation::Mode::DELETE: {
+            auto const& dp = delete_points.at(move.point);
+            delete_at(mutation::DeletePoint(moved_node(dp.delete_node),
+                                            moved(dp.src),
+                                            moved(dp.dst),
+                                            dp.skipper));
+            break;
+        }
+        case mutation::Mode::INSERT: {
+            auto const& ip = insert_points.at(move.point);
+            if (ip.dst.node) {
+                build_bridge(moved(ip.src),
+                             moved(ip.dst),
+                             ip.bridges.at(move.choice));
+            }
+            else {
+                FreeTerm const ft = tip_free_term(moved_node(ip.src.node));
+                _.grow_tip(ft, growable_links(ft).at(move.choice));
+            }
+            break;
+        }
+        case mutation::Mode::SWAP: {
+            auto const& sp = swap_points.at(move.point);
+            if (sp.dst.node) {
+                _.mutable_nodes().erase(moved_node(sp.del_node));
+                build_bridge(moved(sp.src),
+                             moved(sp.dst),
+                             sp.bridges.at(move.choice));
+            }
+            else {
+                auto const pt_link = growable_links(
+                                         sp.src,
+                                         sp.del_node->prototype_).at(move.choice);
+                nip_tip(moved_node(sp.del_node));
+                _.grow_tip(moved(sp.src), pt_link);
+            }
+            break;
+        }
+        default:
+            mutation::bad_mode(move.mode);
+        }
+    }
+
+    bool local_search(size_t const budget)
+    {
+        // Points are collected once on this team, which is only read. Each
+        // neighbor finds them among its own copy of the nodes.
+        auto const delete_points = _.size() > 1 ?
+                                   collect_delete_points() :
+                                   std::vector<mutation::DeletePoint>();
+        auto const insert_points = collect_insert_points();
+        auto const swap_points = collect_swap_points();
+
+        std::vector<Move> moves;
+        for (size_t i = 0; i < delete_points.size(); i++) {
+            moves.push_back({mutation::Mode::DELETE, i, 0});
+        }
+        for (size_t i = 0; i < insert_points.size(); i++) {
+            auto const& ip = insert_points[i];
+            size_t const n_choices = ip.dst.node ?
+                                     ip.bridges.size() :
+                                     growable_links(
+                                         tip_free_term(ip.src.node)).size();
+            for (size_t choice = 0; choice < n_choices; choice++) {
+                moves.push_back({mutation::Mode::INSERT, i, choice});
+            }
+        }
+        for (size_t i = 0; i < swap_points.size(); i++) {
+            auto const& sp = swap_points[i];
+            size_t const n_choices = sp.dst.node ?
+                                     sp.bridges.size() :
+                                     growable_links(
+                                         sp.src,
+                                         sp.del_node->prototype_).size();
+            for (size_t choice = 0; choice < n_choices; choice++) {
+                moves.push_back({mutation::Mode::SWAP, i, choice});
+            }
+        }
+
+        // Over budget, try a random subset of the moves.
+        if (moves.size() > budget) {
+            for (size_t i = 0; i < budget; i++) {
+                std::swap(moves[i],
+                          moves[i + random::get_dice(moves.size() - i,
+                                                     _.seed_)]);
+            }
+            moves.resize(budget);
+        }
+
+        // Neighbors are built in candidate, which swaps places with best
+        // whenever it beats it, so that both keep reusing their nodes.
+        NodeTeamSP candidate = _.clone();
+        NodeTeamSP best;
+        for (auto const& move : moves) {
+            auto& neighbor = static_cast<PathTeam&>(*candidate);
+            neighbor.copy(_);
+            neighbor.seed_ = _.seed_;
+            neighbor.unshare_nodes();
+
+            neighbor.pimpl_->apply(move,
+                                   delete_points,
+                                   insert_points,
+                                   swap_points);
+            neighbor.mutation_invariance_check();
+            neighbor.evaluate();
+
+            float const best_score = best ? best->score() : _.score();
+            if (neighbor.score() < best_score) {
+                std::swap(candidate, best);
+                if (not candidate) {
+                    candidate = _.clone();
+                }
+            }
+        }
+
+        if (best) {
+            _.virtual_copy(*best);
+            return true;
+        }
+
+        return false;
+    }
 };
 
 /* protected */
@@ -670,15 +869,50 @@ bool PathTeam::is_mutable(NodeKey const tip) const {
     return true;
 }
 
+bool PathTeam::in_spec_frame() const {
+    // Free teams are aligned by Kabsch for scoring, collision with fixed
+    // modules and export.
+    return false;
+}
+
 void PathTeam::postprocess_json(JSON& output) const {}
 
 /* modifiers */
+NodePool& PathTeam::mutable_nodes() {
+    DEBUG_NOMSG(nodes_.use_count() > 1);
+    return *nodes_;
+}
+
+std::shared_ptr<NodePool> PathTeam::take_spare_nodes() {
+    if (spare_nodes_) {
+        return std::move(spare_nodes_);
+    }
+
+    return std::make_shared<NodePool>();
+}
+
+void PathTeam::unshare_nodes() {
+    // Only this team can hand out its pool, and it is not doing so now, so a
+    // count of 1 cannot grow behind our back.
+    if (nodes_.use_count() > 1) {
+        auto const shared = std::move(nodes_);
+        nodes_ = take_spare_nodes();
+        nodes_->copy(*shared);
+
+        for (auto& ft : free_terms_) {
+            ft.node = nodes_->counterpart(ft.node);
+        }
+    }
+}
+
 void PathTeam::reset() {
     NodeTeam::reset();
-    nodes_.clear();
+    if (nodes_.use_count() > 1) {
+        nodes_ = take_spare_nodes();
+    }
+    nodes_->clear();
     free_terms_.clear();
     scored_path_ = nullptr;
-    nk_map_.clear();
 }
 
 void PathTeam::virtual_copy(NodeTeam const& other) {
@@ -696,10 +930,7 @@ NodeKey PathTeam::add_node(ProtoModule const* const prot,
                            size_t const n_ft_to_add,
                            FreeTerm const* const exclude_ft)
 {
-    auto new_node = std::make_unique<Node>(prot, tx);
-    auto new_node_key = new_node.get();
-
-    nodes_.emplace(new_node_key, std::move(new_node));
+    NodeKey const new_node_key = mutable_nodes().emplace(prot, tx);
 
     if (not innert) {
         pimpl_->add_free_terms(new_node_key, n_ft_to_add, exclude_ft);
@@ -708,7 +939,7 @@ NodeKey PathTeam::add_node(ProtoModule const* const prot,
     return new_node_key;
 }
 
-NodeKey PathTeam::grow_tip(FreeTerm const& free_term_a,
+NodeKey PathTeam::grow_tip(FreeTerm const free_term_a,
                            ProtoLink const* pt_link,
                            bool const innert)
 {
@@ -741,7 +972,9 @@ NodeKey PathTeam::grow_tip(FreeTerm const& free_term_a,
     pimpl_->get_node(node_a)->add_link(free_term_a, pt_link, free_term_b);
     pimpl_->get_node(node_b)->add_link(free_term_b, pt_link->reverse, free_term_a);
 
-    free_terms_.remove(free_term_a);
+    free_terms_.erase(
+        std::remove(begin(free_terms_), end(free_terms_), free_term_a),
+        end(free_terms_));
 
     // Check that newly grown node is a tip node.
     {
@@ -766,15 +999,23 @@ void PathTeam::fix_limb_transforms(Link const& arrow)
 
 void PathTeam::remove_free_terms(NodeKey const node) {
     // Remove any FreeTerm originating from node
-    free_terms_.remove_if([&](auto const & ft) {
+    free_terms_.erase(
+        std::remove_if(begin(free_terms_), end(free_terms_),
+    [&](auto const & ft) {
         return ft.node == node;
-    });
+    }),
+    end(free_terms_));
 }
 
 void PathTeam::evaluate() {
     calc_checksum();
+    if (load_cached_score()) {
+        return;
+    }
+
     calc_score();
     penalize_collision();
+    save_cached_score();
 }
 
 void PathTeam::calc_checksum() {
@@ -806,13 +1047,19 @@ void PathTeam::calc_score() {
 
     score_ = INFINITY;
 
-    auto const& my_points = gen_path().collect_points();
+    thread_local V3fList my_points;
+    gen_path().collect_points(my_points);
+    size_t const n_points = my_points.size();
 
     auto const& [fwd_ui_key, fwd_path] = *begin(work_area_->path_map);
-    float const fwd_score = scoring::score_aligned(my_points, fwd_path);
-
     auto const& [bwd_ui_key, bwd_path] = *(++begin(work_area_->path_map));
-    float const bwd_score = scoring::score_aligned(my_points, bwd_path);
+
+    float fwd_score, bwd_score;
+    scoring::score_aligned_pair(my_points,
+                                work_area_->ref_path(fwd_ui_key, n_points),
+                                work_area_->ref_path(bwd_ui_key, n_points),
+                                fwd_score,
+                                bwd_score);
 
     if (fwd_score < bwd_score) {
         score_ = fwd_score;
@@ -824,35 +1071,113 @@ void PathTeam::calc_score() {
     }
 }
 
+FitnessCache::Key PathTeam::calc_fingerprint() const {
+    FitnessCache::Key key = FitnessCache::mix(0, collision_penalty_);
+
+    auto path = gen_path();
+    while (not path.is_done()) {
+        auto node = path.next();
+        key = FitnessCache::mix(
+                  key, reinterpret_cast<uintptr_t>(node->prototype_));
+
+        Vector3f const pos = node->tx_.collapsed();
+        key = FitnessCache::mix(key, pos[0]);
+        key = FitnessCache::mix(key, pos[1]);
+        key = FitnessCache::mix(key, pos[2]);
+    }
+
+    return key;
+}
+
+bool PathTeam::load_cached_score() {
+    FitnessCache& cache = work_area_->fitness_cache();
+    if (not cache.enabled()) {
+        return false;
+    }
+
+    fingerprint_ = calc_fingerprint();
+
+    FitnessCache::Entry entry;
+    if (not cache.lookup(fingerprint_, entry)) {
+        return false;
+    }
+
+    // The entry refers to the scored path by its place in path_map.
+    score_ = entry.score;
+    scored_path_ = nullptr;
+    uint32_t ref_id = 0;
+    for (auto const& [ui_key, path] : work_area_->path_map) {
+        if (ref_id++ == entry.ref_id) {
+            scored_path_ = &path;
+        }
+    }
+
+    return true;
+}
+
+void PathTeam::save_cached_score() const {
+    FitnessCache& cache = work_area_->fitness_cache();
+    if (not cache.enabled()) {
+        return;
+    }
+
+    FitnessCache::Entry entry;
+    entry.score = score_;
+    entry.ref_id = UINT32_MAX;
+    uint32_t ref_id = 0;
+    for (auto const& [ui_key, path] : work_area_->path_map) {
+        if (&path == scored_path_) {
+            entry.ref_id = ref_id;
+        }
+        ref_id++;
+    }
+
+    cache.insert(fingerprint_, entry);
+}
+
 void PathTeam::penalize_collision() {
     // Check for collision based on module distance and radii
+    thread_local collision::Spheres spheres;
+    thread_local V3fList points;
+    thread_local std::vector<float> radii;
+    spheres.clear();
+    points.clear();
+    radii.clear();
+
     auto path = gen_path();
-    std::vector<Vector3f> points;
-    std::vector<float> sq_radii;
     while (not path.is_done()) {
         auto node = path.next();
-        points.emplace_back(node->tx_.collapsed());
-        auto const r =  node->prototype_->radius;
-        sq_radii.emplace_back(r * r);
+        points.push_back(node->tx_.collapsed());
+        radii.push_back(node->prototype_->radius);
+        spheres.push_back(points.back(), radii.back());
     }
-    auto const n = points.size();
-    bool colliding = false;
-    for (int i = 0; i < n; ++i) {
-        auto p1 = points.at(i);
-        auto r1 = sq_radii.at(i);
-        for (int j = 0; j < n; ++j) {
-            if (j == i) continue;
-            auto p2 = points.at(j);
-            auto max_sq_radii = max(r1, sq_radii.at(j));
-            if (p1.sq_dist_to(p2) < max_sq_radii) {
-                colliding = true;
-                break;
+
+    // Penalize score if there's collision, either within the team or with
+    // modules fixed by the spec.
+    bool collides = collision::any_overlap(spheres);
+    if (not collides and work_area_->fixed_modules.size() > 0) {
+        if (in_spec_frame()) {
+            collides = work_area_->fixed_modules.overlaps_any(spheres);
+        }
+        else if (scored_path_) {
+            // Fixed modules are in the spec's frame, so move the team onto
+            // the path it scored against first, like to_json() does.
+            elfin::Mat3f rot;
+            Vector3f tran;
+            scoring::calc_alignment(points, *scored_path_, rot, tran);
+            Transform const kabsch_alignment(rot, tran);
+
+            thread_local collision::Spheres aligned_spheres;
+            aligned_spheres.clear();
+            for (size_t i = 0; i < points.size(); ++i) {
+                aligned_spheres.push_back(kabsch_alignment * points[i],
+                                          radii[i]);
             }
+            collides = work_area_->fixed_modules.overlaps_any(aligned_spheres);
         }
     }
 
-    // Penalize score if there's collision
-    if (colliding) {
+    if (collides) {
         score_ += score_ * collision_penalty_;
     }
 }
@@ -924,9 +1249,10 @@ void PathTeam::virtual_implement_recipe(
 
 /* public */
 /* ctors */
-PathTeam::PathTeam(WorkArea const* const wa, uint32_t const seed_) :
+PathTeam::PathTeam(WorkArea const* const wa, random::Stream const& seed_) :
     NodeTeam(wa, seed_),
-    pimpl_(new_pimpl<PImpl>(*this)) {}
+    pimpl_(new_pimpl<PImpl>(*this)),
+    nodes_(std::make_shared<NodePool>()) {}
 
 PathTeam::PathTeam(PathTeam const& other) :
     PathTeam(other.work_area_, other.seed_)
@@ -940,6 +1266,26 @@ PathTeam::PathTeam(PathTeam&& other) :
 PathTeam::~PathTeam() {}
 
 /* accessors */
+void PathTeam::write_checkpoint(checkpoint::Writer& writer) const {
+    NodeTeam::write_checkpoint(writer);
+
+    nodes_->write_checkpoint(writer);
+
+    writer.put<uint64_t>(free_terms_.size());
+    for (auto const& free_term : free_terms_) {
+        nodes_->write_term(writer, free_term);
+    }
+
+    // Paths are found by the name of their joint.
+    std::string scored_joint_name = "";
+    for (auto const& [ui_key, path] : work_area_->path_map) {
+        if (&path == scored_path_) {
+            scored_joint_name = ui_key->name;
+        }
+    }
+    writer.put_string(scored_joint_name);
+}
+
 PathGenerator PathTeam::gen_path() const {
     return PathGenerator(get_tip(/*mutable_hint=*/false));
 }
@@ -949,31 +1295,16 @@ PathTeam& PathTeam::operator=(PathTeam const& other) {
     if (this != &other) {
         NodeTeam::operator=(other);
 
-        // Clone nodes and create address mapping for remapping pointers.
-        {
-            // Create new node addr mapping: other addr -> my addr
-            nk_map_.clear();
-            nodes_.clear();
-
-            for (auto& [other_nk, other_node] : other.nodes_) {
-                NodeSP my_node = other_node->clone();
-                nk_map_[other_nk] = my_node.get();
-                nodes_.emplace(my_node.get(), std::move(my_node));
-            }
-
-            // Fix pointer addresses and assign to my own nodes.
-            for (auto& [nk, node] : nodes_) {
-                node->update_link_ptrs(nk_map_);
+        // Share other's nodes, so NodeKeys carry over as they are.
+        if (nodes_ != other.nodes_) {
+            if (nodes_.use_count() == 1) {
+                spare_nodes_ = std::move(nodes_);
             }
-
-            // Copy free_terms_.
-            free_terms_ = other.free_terms_;
-            for (auto& ft : free_terms_) {
-                ft.node = nk_map_.at(ft.node);
-            }
-
-            scored_path_ = other.scored_path_;
+            nodes_ = other.nodes_;
         }
+
+        free_terms_ = other.free_terms_;
+        scored_path_ = other.scored_path_;
     }
 
     return *this;
@@ -984,33 +1315,66 @@ PathTeam& PathTeam::operator=(PathTeam&& other) {
         NodeTeam::operator=(std::move(other));
 
         std::swap(nodes_, other.nodes_);
+        std::swap(spare_nodes_, other.spare_nodes_);
         std::swap(free_terms_, other.free_terms_);
         std::swap(scored_path_, other.scored_path_);
-        std::swap(nk_map_, other.nk_map_);
     }
 
     return *this;
 }
 
+void PathTeam::read_checkpoint(checkpoint::Reader& reader) {
+    NodeTeam::read_checkpoint(reader);
+
+    NodePool& nodes = mutable_nodes();
+    nodes.read_checkpoint(reader);
+
+    free_terms_.clear();
+    size_t const n_free_terms = reader.get<uint64_t>();
+    for (size_t i = 0; i < n_free_terms; ++i) {
+        free_terms_.push_back(nodes.read_term(reader));
+    }
+
+    scored_path_ = nullptr;
+    std::string const scored_joint_name = reader.get_string();
+    if (not scored_joint_name.empty()) {
+        auto const joint_itr = work_area_->joints.find(scored_joint_name);
+        PANIC_IF(joint_itr == end(work_area_->joints),
+                 CouldNotParse("Checkpoint refers to missing joint " +
+                               scored_joint_name));
+        scored_path_ = &work_area_->path_map.at(joint_itr->second.get());
+    }
+}
+
 void PathTeam::randomize() {
     pimpl_->randomize();
     evaluate();
 }
 
-mutation::Mode PathTeam::evolve(NodeTeam const& mother,
-                                NodeTeam const& father)
+void PathTeam::evolve(NodeTeam const& mother,
+                      NodeTeam const& father,
+                      mutation::Scheduler const& scheduler,
+                      mutation::Record& record)
 {
+    // Mutations hold NodeKeys across modifications, so the nodes shared with
+    // mother are copied up front rather than on first write.
     virtual_copy(mother);
+    unshare_nodes();
 
     auto modes = mutation::gen_mode_list();
 
+    record.clear();
+    record.parent_score = mother.score();
+
     bool mutate_success = false;
     mutation::Mode mode = mutation::Mode::NONE;
 
     while (not mutate_success and not modes.empty()) {
         mutation_invariance_check();
 
-        mode = random::pop(modes, seed_);
+        mode = scheduler.pop(modes, seed_);
+        size_t const size_before = size();
+        auto const mode_start = std::chrono::steady_clock::now();
         switch (mode) {
         case mutation::Mode::ERODE:
             mutate_success = pimpl_->erode_mutate();
@@ -1033,18 +1397,79 @@ mutation::Mode PathTeam::evolve(NodeTeam const& mother,
         default:
             mutation::bad_mode(mode);
         }
+        // Nodes scanned for mutation points and held after the try stand in
+        // for its cost when weighing modes, as they do not vary between runs.
+        size_t const nodes_touched = size_before + size() +
+                                     (mode == mutation::Mode::CROSS ?
+                                      father.size() : 0);
+        record.add_try(mode,
+                       std::chrono::duration<float, std::nano>(
+                           std::chrono::steady_clock::now() - mode_start).count(),
+                       nodes_touched);
 
         mutation_invariance_check();
     }
 
-    if (not mutate_success) {
+    if (mutate_success) {
+        record.mode = mode;
+    }
+    else {
         pimpl_->randomize();
         mutate_success = true;
     }
+}
 
-    evaluate();
+bool PathTeam::local_search(size_t const budget) {
+    return pimpl_->local_search(budget);
+}
+
+bool PathTeam::prepare_score() {
+    calc_checksum();
+    return not load_cached_score();
+}
 
-    return mode;
+void PathTeam::pack_points(scoring::PointBatch& batch,
+                           size_t const set) const
+{
+    size_t i = 0;
+    auto path = gen_path();
+    while (not path.is_done()) {
+        batch.set_point(set, i++, path.next()->tx_.collapsed());
+    }
+    DEBUG_NOMSG(i != batch.size_of(set));
+
+    // Score forward and backward, same as calc_score().
+    auto const& [fwd_ui_key, fwd_path] = *begin(work_area_->path_map);
+    auto const& [bwd_ui_key, bwd_path] = *(++begin(work_area_->path_map));
+    batch.set_ref_mask(set,
+                       (1 << batch.ref_id(&fwd_path)) |
+                       (1 << batch.ref_id(&bwd_path)));
+}
+
+void PathTeam::finish_score(scoring::PointBatch const& batch,
+                            size_t const set)
+{
+    auto const& [fwd_ui_key, fwd_path] = *begin(work_area_->path_map);
+    float const fwd_score = batch.score(set, batch.ref_id(&fwd_path));
+
+    auto const& [bwd_ui_key, bwd_path] = *(++begin(work_area_->path_map));
+    float const bwd_score = batch.score(set, batch.ref_id(&bwd_path));
+
+    if (fwd_score < bwd_score) {
+        score_ = fwd_score;
+        scored_path_ = &fwd_path;
+    }
+    else {
+        score_ = bwd_score;
+        scored_path_ = &bwd_path;
+    }
+
+    // Teams already past the cutoff will not survive; spare the penalty.
+    // Only then is the score final and worth caching.
+    if (score_ <= batch.cutoff()) {
+        penalize_collision();
+        save_cached_score();
+    }
 }
 
 /* printers */
@@ -1086,7 +1511,10 @@ JSON PathTeam::to_json() const {
 
             auto const& [fwd_ui_key, fwd_path] = *begin(work_area_->path_map);
             scoring::calc_alignment(
-                /*mobile=*/ points, /*ref=*/ fwd_path, rot, tran);
+                /*mobile=*/ points,
+                /*ref=*/ work_area_->ref_path(fwd_ui_key, points.size()),
+                rot,
+                tran);
         }
 
         Transform const kabsch_alignment(rot, tran);
@@ -1,5 +1,7 @@
 #include "path_team.h"
 
+#include <thread>
+
 #include "test_data.h"
 #include "test_stat.h"
 #include "input_manager.h"
@@ -63,6 +65,46 @@ TestStat PathTeam::test() {
 
             JUtil.error(inp_oss.str().c_str());
         }
+
+        // A copy shares nodes until unshared, and must then have the same
+        // path, made of its own nodes.
+        ts.tests++;
+        PathTeam copy(team);
+        bool copy_ok = copy.nodes_ == team.nodes_;
+        copy.unshare_nodes();
+
+        auto const& keys = team.gen_path().collect_keys();
+        auto const& copy_keys = copy.gen_path().collect_keys();
+        copy_ok = copy_ok and
+                  copy.nodes_ != team.nodes_ and
+                  copy.size() == team.size() and
+                  copy_keys.size() == keys.size();
+        for (size_t i = 0; copy_ok and i < keys.size(); ++i) {
+            copy_ok = copy_keys[i] != keys[i] and
+                      copy_keys[i]->prototype_ == keys[i]->prototype_ and
+                      copy_keys[i]->tx_.collapsed().dist_to(
+                          keys[i]->tx_.collapsed()) == 0;
+        }
+
+        if (not copy_ok) {
+            ts.errors++;
+            JUtil.error("PathTeam copy test of %s failed.\n",
+                        spec_file.c_str());
+        }
+
+        // Chunks of a destroyed team must go back to the arena.
+        ts.tests++;
+        size_t const arena_bytes = NodeArena::bytes_in_use();
+        {
+            PathTeam temp(team);
+            temp.unshare_nodes();
+        }
+        if (NodeArena::bytes_in_use() != arena_bytes) {
+            ts.errors++;
+            JUtil.error("Node arena leaked %zu bytes in test of %s.\n",
+                        NodeArena::bytes_in_use() - arena_bytes,
+                        spec_file.c_str());
+        }
     };
 
     // Short construction test.
@@ -78,6 +120,117 @@ TestStat PathTeam::test() {
         JUtil.warn("TODO: PathTeam mutation operator tests\n");
     }
 
+    // Local search test.
+    {
+        InputManager::setup_test({"--spec_file",
+                                  "examples/quarter_snake_free.json"});
+        Spec const spec(OPTIONS);
+        auto const wa = (*begin(spec.work_packages()))->work_area_keys().at(0);
+
+        // A team that already fits cannot be improved upon.
+        ts.tests++;
+        PathTeam fit(wa, OPTIONS.seed);
+        fit.implement_recipe(tests::QUARTER_SNAKE_FREE_RECIPE);
+        Crc32 const fit_checksum = fit.checksum();
+        if (fit.local_search(/*budget=*/ 64) or
+                fit.checksum() != fit_checksum) {
+            ts.errors++;
+            JUtil.error("PathTeam local search changed a fitting team\n");
+        }
+
+        // Equal teams searched with the same budget end up equal, and never
+        // worse than they started.
+        ts.tests++;
+        PathTeam team(wa, OPTIONS.seed);
+        team.randomize();
+        float const start_score = team.score();
+
+        PathTeam copy(team);
+        bool const improved = team.local_search(/*budget=*/ 16);
+        copy.local_search(/*budget=*/ 16);
+
+        if (team.checksum() != copy.checksum() or
+                team.score() != copy.score() or
+                team.score() > start_score or
+                improved != (team.score() < start_score)) {
+            ts.errors++;
+            JUtil.error("PathTeam local search test failed: "
+                        "scores %f and %f from %f\n",
+                        team.score(), copy.score(), start_score);
+        }
+    }
+
+    // Node arena reuse test. Teams made on new threads and destroyed on this
+    // one, as populations are between restarts, must reuse freed chunks
+    // rather than take new slabs each time. This thread may keep up to two
+    // slabs' worth for itself.
+    {
+        InputManager::setup_test({"--spec_file",
+                                  "examples/quarter_snake_free.json"});
+        Spec const spec(OPTIONS);
+        auto const wa = (*begin(spec.work_packages()))->work_area_keys().at(0);
+
+        PathTeam team(wa, OPTIONS.seed);
+        team.implement_recipe(tests::QUARTER_SNAKE_FREE_RECIPE);
+
+        size_t first_reserved = 0;
+        for (size_t cycle = 0; cycle < 8; ++cycle) {
+            std::vector<std::unique_ptr<PathTeam>> copies;
+            std::thread([&] {
+                for (size_t i = 0; i < 4096; ++i) {
+                    copies.push_back(std::make_unique<PathTeam>(team));
+                    copies.back()->unshare_nodes();
+                }
+            }).join();
+            copies.clear();
+
+            if (cycle == 0) {
+                first_reserved = NodeArena::bytes_reserved();
+            }
+        }
+
+        ts.tests++;
+        size_t const reserved = NodeArena::bytes_reserved();
+        if (reserved > first_reserved + 2 * NodeArena::SLAB_BYTES) {
+            ts.errors++;
+            JUtil.error("Node arena grew from %zu to %zu bytes over "
+                        "repeated cycles\n", first_reserved, reserved);
+        }
+    }
+
+    // Fixed module collision test. The spec puts a fixed module on a joint
+    // of the path. A free team is built in a frame of its own, but once
+    // aligned to the path it lands on the module and is penalized.
+    {
+        InputManager::setup_test({"--spec_file",
+                                  "examples/quarter_snake_free_fixed.json"});
+        Spec const spec(OPTIONS);
+        auto const wa = (*begin(spec.work_packages()))->work_area_keys().at(0);
+
+        ts.tests++;
+        PathTeam team(wa, OPTIONS.seed);
+        team.collision_penalty_ = 1.0f;
+        team.implement_recipe(tests::QUARTER_SNAKE_FREE_RECIPE);
+
+        collision::Spheres spheres;
+        auto path = team.gen_path();
+        while (not path.is_done()) {
+            auto node = path.next();
+            spheres.push_back(node->tx_.collapsed(), node->prototype_->radius);
+        }
+        TRACE(collision::any_overlap(spheres),
+              "Free team collides with itself.\n");
+
+        team.score_ = 1.0f;
+        team.penalize_collision();
+        if (team.score_ != 2.0f) {
+            ts.errors++;
+            JUtil.error("PathTeam fixed module collision test failed: "
+                        "free team on a fixed module scored %f instead of "
+                        "2\n", team.score_);
+        }
+    }
+
     // Checksum test.
     {
         ts.tests++;
@@ -1,30 +1,51 @@
 #include "population.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <sstream>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
 
 #include "input_manager.h"
 #include "parallel_utils.h"
 #include "path_team.h"
+#include "node_pool.h"
+#include "first_rank_table.h"
 
 namespace elfin {
 
-void print_mutation_ratios(mutation::ModeList const& mode_tally) {
+// Estimated cost of copying a survivor, which shares its nodes, in time and
+// in nodes touched.
+static float const COPY_COST_NS = 1e3;
+static float const COPY_COST_NODES = 0.1f;
+
+// Share of parents drawn from the node of their child under the local NUMA
+// policy. The rest keep the gene pool mixed across nodes.
+static float const LOCAL_PARENT_RATE = 0.9f;
+
+// Survivors count under NONE, along with children that had to be
+// randomized.
+void print_mutation_ratios(std::vector<mutation::Record> const& records,
+                           size_t const survivors) {
+    size_t const pop_size = survivors + records.size();
     if (JUtil.check_log_lvl(LOGLVL_DEBUG)) {
         mutation::Counter mc;
-        for (auto mode : mode_tally) {
-            mc[mode]++;
+        mc[mutation::Mode::NONE] = survivors;
+        for (auto const& record : records) {
+            mc[record.mode]++;
         }
 
         auto mutation_modes = mutation::gen_mode_list();
         mutation_modes.insert(begin(mutation_modes), mutation::Mode::NONE);
 
         std::ostringstream mutation_ss;
-        mutation_ss << "Mutation Ratios (out of " << CUTOFFS.pop_size << "):\n";
+        mutation_ss << "Mutation Ratios (out of " << pop_size << "):\n";
         for (auto const& mode : mutation_modes) {
             mutation_ss << "  " << mutation::ModeToCStr(mode) << ':';
 
-            float const mode_ratio = 100.f * mc[mode] / CUTOFFS.pop_size;
+            float const mode_ratio = 100.f * mc[mode] / pop_size;
             mutation_ss << " " << string_format("%.1f", mode_ratio) << "% ";
             mutation_ss << "(" << mc[mode] << ")\n";
         }
@@ -33,12 +54,119 @@ void print_mutation_ratios(mutation::ModeList const& mode_tally) {
     }
 }
 
+// Scores a team on its own, for when teams are not made in lockstep.
+void score_alone(NodeTeam& team,
+                 scoring::PointBatch& batch,
+                 float const cutoff = INFINITY) {
+    if (team.prepare_score()) {
+        batch.resize(std::vector<size_t>(1, team.size()));
+        batch.set_cutoff(cutoff);
+        team.pack_points(batch, 0);
+        scoring::score_aligned_batch(batch);
+        team.finish_score(batch, 0);
+    }
+}
+
+std::vector<scoring::CenteredPath const*> collect_ref_paths(
+    WorkArea const* work_area) {
+    std::vector<scoring::CenteredPath const*> refs;
+    for (auto const& [ui_key, path] : work_area->path_map) {
+        refs.push_back(&work_area->centered_path_map.at(ui_key));
+    }
+    return refs;
+}
+
+// Survivors of the last generation are copied to the front with their scores.
+// If their checksums are distinct, select() keeps no team scoring above the
+// worst of them, so score() may cut off there. Otherwise select() can reach
+// past them and nothing can be cut off. A negative collision penalty could
+// lower a score below its bound, and keeping more solutions than survivors
+// would let bounded scores into the output, so both disable the cutoff too.
+float survivor_cutoff(std::vector<NodeTeamSP> const& teams,
+                      size_t const survivors) {
+    if (OPTIONS.collision_penalty < 0 or OPTIONS.keep_n > survivors) {
+        return INFINITY;
+    }
+
+    std::unordered_set<Crc32> checksums;
+    float cutoff = 0;
+    for (size_t rank = 0; rank < survivors; rank++) {
+        auto const& team = teams.at(rank);
+        if (not checksums.insert(team->checksum()).second) {
+            return INFINITY;
+        }
+        cutoff = std::max(cutoff, team->score());
+    }
+    return cutoff;
+}
+
+/* protected */
+/* accessors */
+random::Stream Population::stream_of(size_t const individual) const {
+    return random::Stream(
+               random::derive(random::derive(key_, generation_), individual));
+}
+
+/* modifiers */
+void Population::plant_seeds(NodeTeams& teams, seeding::Seeds const& seeds) {
+    size_t const pop_size = teams.size();
+    size_t const n_seeded = seeds.empty() ? 0 :
+                            std::min(pop_size, (size_t) std::round(
+                                         OPTIONS.seed_rate * pop_size));
+    size_t const n_rebuilt = std::min(n_seeded, seeds.size());
+
+    OMP_PAR_FOR
+    for (size_t i = 0; i < n_rebuilt; i++) {
+        auto const path_team = dynamic_cast<PathTeam*>(teams.at(i).get());
+        PANIC_IF(not path_team, Unsupported("Cannot seed non-path teams"));
+        path_team->implement_recipe(seeds.at(i).recipe, seeds.at(i).shift_tx);
+    }
+
+    // The rest are mutants of the rebuilt seeds, as if they were survivors.
+    std::vector<mutation::Record> records(n_seeded - n_rebuilt);
+
+    #pragma omp parallel
+    {
+        scoring::PointBatch batch(batch_.centered_paths());
+
+        #pragma omp for schedule(dynamic)
+        for (size_t i = n_rebuilt; i < n_seeded; i++) {
+            auto& team = teams.at(i);
+            auto const& mother = *teams.at(random::get_dice(n_rebuilt, team->seed_));
+            auto const& father = *teams.at(random::get_dice(n_rebuilt, team->seed_));
+            auto& record = records.at(i - n_rebuilt);
+            team->evolve(mother, father, scheduler_, record);
+            score_alone(*team, batch);
+            record.child_score = team->score();
+        }
+    }
+
+    if (not records.empty()) {
+        scheduler_.update(records);
+    }
+
+    std::stable_sort(begin(teams), end(teams), NodeTeam::SPLess());
+
+    if (n_seeded) {
+        JUtil.info("Seeded %zu teams from %zu solutions\n",
+                   n_seeded, n_rebuilt);
+    }
+}
+
 /* public */
 /* ctors */
-Population::Population(WorkArea const* work_area, uint32_t& seed) {
+Population::Population(WorkArea const* work_area,
+                       uint64_t const key,
+                       Cutoffs const& cutoffs,
+                       seeding::Seeds const& seed_solutions) :
+    cutoffs_(cutoffs),
+    batch_(collect_ref_paths(work_area)),
+    key_(key),
+    scheduler_(OPTIONS.ga_mutation_schedule == "adaptive")
+{
     TIMING_START(init_start_time);
     {
-        size_t const pop_size = OPTIONS.ga_pop_size;
+        size_t const pop_size = cutoffs_.pop_size;
         if (JUtil.check_log_lvl(LOGLVL_INFO)) {
             fprintf(stdout, "\n");
             JUtil.info("Initializing population of %u...\n", pop_size);
@@ -47,35 +175,42 @@ Population::Population(WorkArea const* work_area, uint32_t& seed) {
         NodeTeams* new_front_buffer = &teams[0];
         NodeTeams* new_back_buffer = &teams[1];
 
+        // A steady state population starts with its random teams in the
+        // front buffer and never uses the back buffer.
+        bool const steady_state = OPTIONS.ga_mode == "steady_state";
+        NodeTeams* const random_buffer =
+            steady_state ? new_front_buffer : new_back_buffer;
+
         // Pre allocation required for parallel assignment.
         new_front_buffer->resize(pop_size);
-        new_back_buffer->resize(pop_size);
-
-        // Create seeds. This needs to be done on a single thread for reproducibilitiy.
-        std::vector<uint32_t> seeds(pop_size, 0);
-        {
-            for (size_t i = 0; i < pop_size; i++) {
-                seeds[i] = rand_r(&seed);
-            }
+        if (not steady_state) {
+            new_back_buffer->resize(pop_size);
         }
 
-        OMP_PAR_FOR
-        for (size_t i = 0; i < pop_size; i++) {
-            auto seed = seeds.at(i);
+        // Generation 0 is the random one.
+        auto const cost = [](size_t) { return 1.0f; };
+        auto const home_nodes = parallel::task_nodes(pop_size, cost);
+        auto const times = parallel::run_tasks(pop_size, cost,
+        [&](size_t const i) {
             {
-                auto team = NodeTeam::create_team(work_area, seed);
+                auto team = NodeTeam::create_team(work_area, stream_of(i));
                 team->collision_penalty_ = OPTIONS.collision_penalty;
-                new_back_buffer->at(i) = std::move(team);
-                new_back_buffer->at(i)->randomize();
+                team->home_node_ = home_nodes[i];
+                random_buffer->at(i) = std::move(team);
+                random_buffer->at(i)->randomize();
             }
 
-            {   
-                auto const next_seed = rand_r(&seed);
-                auto team = NodeTeam::create_team(work_area, seed);
+            if (not steady_state) {
+                auto team = NodeTeam::create_team(work_area, stream_of(i));
                 team->collision_penalty_ = OPTIONS.collision_penalty;
+                team->home_node_ = home_nodes[i];
                 new_front_buffer->at(i) = std::move(team);
             }
-        }
+        });
+        times.print("initialization");
+
+        plant_seeds(*random_buffer, seed_solutions);
+        generation_++;
 
         front_buffer_ = new_front_buffer;
         back_buffer_ = new_back_buffer;
@@ -83,106 +218,603 @@ Population::Population(WorkArea const* work_area, uint32_t& seed) {
     TIMING_END("initialization", init_start_time);
 }
 
+Population::Population(WorkArea const* work_area,
+                       checkpoint::Reader& reader,
+                       Cutoffs const& cutoffs) :
+    cutoffs_(cutoffs),
+    batch_(collect_ref_paths(work_area)),
+    scheduler_(OPTIONS.ga_mutation_schedule == "adaptive")
+{
+    TIMING_START(init_start_time);
+    {
+        JUtil.info("Resuming population of %zu...\n", cutoffs_.pop_size);
+
+        size_t const front_id = reader.get<uint8_t>();
+        PANIC_IF(front_id > 1,
+                 CouldNotParse("Checkpoint has a bad population"));
+        front_buffer_ = &teams[front_id];
+        back_buffer_ = &teams[1 - front_id];
+
+        key_ = reader.get<uint64_t>();
+        generation_ = reader.get<uint64_t>();
+        scheduler_.read_checkpoint(reader);
+
+        // Each team takes at least its home node.
+        for (auto& buffer : teams) {
+            size_t const n_teams = reader.get_length(sizeof(uint64_t));
+            PANIC_IF(n_teams > OPTIONS.ga_pop_size,
+                     CouldNotParse("Checkpoint population is too large"));
+            buffer.resize(n_teams);
+            for (auto& team : buffer) {
+                team = NodeTeam::create_team(work_area, 0);
+                team->read_checkpoint(reader);
+            }
+        }
+
+        PANIC_IF(front_buffer_->size() != cutoffs_.pop_size,
+                 CouldNotParse("Checkpoint population size does not match"));
+    }
+    TIMING_END("resumption", init_start_time);
+}
+
 /* dtors */
 Population::~Population() {}
 
+/* accessors */
+void Population::write_checkpoint(checkpoint::Writer& writer) const {
+    writer.put<uint8_t>(front_buffer_ == &teams[0] ? 0 : 1);
+    writer.put(key_);
+    writer.put(generation_);
+    scheduler_.write_checkpoint(writer);
+
+    for (auto const& buffer : teams) {
+        writer.put<uint64_t>(buffer.size());
+        for (auto const& team : buffer) {
+            team->write_checkpoint(writer);
+        }
+    }
+}
+
 /* modifiers */
 void Population::evolve() {
     TIMING_START(evolve_start_time);
     {
         JUtil.info("Evolving population...\n");
 
-        mutation::ModeList mutation_mode_tally(
-            CUTOFFS.pop_size, mutation::Mode::NONE);
+        size_t const survivors = cutoffs_.survivors;
+
+        // Filled in by score() once the children have their scores.
+        mutation_records_.resize(cutoffs_.non_survivors);
+
+        // Under the local NUMA policy, children mostly take parents built
+        // on the node expected to evolve them. Until parents are chosen, all
+        // children are expected to cost the same. Teams are placed by nodes
+        // touched rather than time, so that parents are drawn the same way
+        // on every run.
+        size_t const n_nodes = parallel::n_nodes();
+        bool const numa_local =
+            OPTIONS.numa_policy == "local" and n_nodes > 1;
+        std::vector<std::vector<size_t>> local_survivors(
+            numa_local ? n_nodes : 0);
+        for (size_t rank = 0; numa_local and rank < survivors; rank++) {
+            size_t const node = back_buffer_->at(rank)->home_node_;
+            local_survivors.at(std::min(node, n_nodes - 1)).push_back(rank);
+        }
 
-        OMP_PAR_FOR
-        for (size_t rank = 0; rank < CUTOFFS.pop_size; rank++) {
-            mutation::Mode mode = mutation::Mode::NONE;
+        float const child_cost_nodes = scheduler_.child_cost_nodes();
+        std::vector<size_t> expected_nodes;
+        if (numa_local) {
+            expected_nodes = parallel::task_nodes(
+                                 cutoffs_.pop_size,
+            [&](size_t const rank) {
+                return rank < survivors ? COPY_COST_NODES : child_cost_nodes;
+            });
+        }
+
+        auto const pick_parent =
+        [&](size_t const rank, random::Stream& seed) -> size_t {
+            if (numa_local) {
+                auto const& local = local_survivors.at(expected_nodes[rank]);
+                if (not local.empty() and
+                        random::get_dice_0to1(seed) < LOCAL_PARENT_RATE) {
+                    return random::pick(local, seed);
+                }
+            }
+            return random::get_dice(survivors, seed);
+        };
+
+        // Choose parents up front, so that the cost of each child can be
+        // estimated from its mother.
+        std::vector<std::pair<size_t, size_t>> parent_ids(
+            cutoffs_.non_survivors);
+        for (size_t i = 0; i < parent_ids.size(); i++) {
+            size_t const rank = survivors + i;
+            auto& team = front_buffer_->at(rank);
+            team->seed_ = stream_of(rank);
+            parent_ids[i].first = pick_parent(rank, team->seed_);
+            parent_ids[i].second = pick_parent(rank, team->seed_);
+        }
 
+        // Children cost about what recent ones did, scaled by the size of
+        // their mothers, which bounds the points each mode enumerates.
+        double survivor_size = 0;
+        for (size_t rank = 0; rank < survivors; rank++) {
+            survivor_size += back_buffer_->at(rank)->size();
+        }
+        float const mean_size = survivor_size / survivors;
+        auto const scaled_cost = [&](size_t const rank,
+                                     float const copy_cost,
+                                     float const child_cost) {
+            if (rank < survivors) return copy_cost;
+            size_t const mother_id = parent_ids[rank - survivors].first;
+            return child_cost *
+                   (1 + back_buffer_->at(mother_id)->size()) /
+                   (1 + mean_size);
+        };
+
+        // Teams are placed by where they are expected to be built rather
+        // than by the CPU that happened to build them. Only the split of
+        // work among threads goes by time.
+        auto const home_nodes = parallel::task_nodes(
+                                    cutoffs_.pop_size,
+        [&](size_t const rank) {
+            return scaled_cost(rank, COPY_COST_NODES, child_cost_nodes);
+        });
+        float const child_cost_ns = scheduler_.child_cost_ns();
+        auto const cost = [&](size_t const rank) {
+            return scaled_cost(rank, COPY_COST_NS, child_cost_ns);
+        };
+
+        // Parents read from another node than the one evolving the child.
+        std::atomic<size_t> n_remote_parents(0);
+
+        auto const times = parallel::run_tasks(cutoffs_.pop_size, cost,
+        [&](size_t const rank) {
             auto& team = front_buffer_->at(rank);
             // Rank is 0-indexed, hence <
-            if (rank < CUTOFFS.survivors) {
+            if (rank < survivors) {
+                // Copies share the nodes of their source.
                 team->copy(*back_buffer_->at(rank));
-                mode = mutation::Mode::NONE;
+                team->home_node_ = back_buffer_->at(rank)->home_node_;
             }
             else {
-                // Choose parents.
-                size_t const mother_id =
-                    random::get_dice(CUTOFFS.survivors, team->seed_);
-                auto& mother_team = back_buffer_->at(mother_id);
-                size_t const father_id =
-                    random::get_dice(CUTOFFS.survivors, team->seed_);
-                auto& father_team = back_buffer_->at(father_id);
-
-                mode = team->evolve(*mother_team, *father_team);
+                auto const& [mother_id, father_id] =
+                    parent_ids[rank - survivors];
+                auto const& mother = *back_buffer_->at(mother_id);
+                auto const& father = *back_buffer_->at(father_id);
+                team->evolve(mother,
+                             father,
+                             scheduler_,
+                             mutation_records_.at(rank - survivors));
+
+                // Counted against where the child actually runs, which may
+                // differ from where it is expected to.
+                size_t const node = parallel::this_node();
+                n_remote_parents += (mother.home_node_ != node) +
+                                    (father.home_node_ != node);
+                team->home_node_ = home_nodes[rank];
             }
+        });
 
-            mutation_mode_tally[rank] = mode;
+        times.print("evolution");
+        if (n_nodes > 1 and cutoffs_.non_survivors) {
+            JUtil.info("Cross-node parent ratio: %.1f%%\n",
+                       100.0 * n_remote_parents /
+                       (2 * cutoffs_.non_survivors));
         }
+        #pragma omp atomic
+        InputManager::ga_times().evolve_idle_time += times.mean_idle_ms();
 
-        print_mutation_ratios(mutation_mode_tally);
+        generation_++;
+        print_mutation_ratios(mutation_records_, cutoffs_.survivors);
+
+        JUtil.debug("Node arena: %.1f MB in use of %.1f MB reserved\n",
+                    NodeArena::bytes_in_use() / 1048576.0,
+                    NodeArena::bytes_reserved() / 1048576.0);
     }
+    #pragma omp atomic
     InputManager::ga_times().evolve_time +=
         TIMING_END("evolution", evolve_start_time);
 }
 
+void Population::evolve_steady_state() {
+    TIMING_START(evolve_start_time);
+    {
+        JUtil.info("Evolving population (steady state)...\n");
+
+        NodeTeams& teams = *front_buffer_;
+        size_t const pop_size = teams.size();
+        size_t const n_children = cutoffs_.non_survivors;
+
+        // Max-heap of (score, index) so that the worst team is on top, and
+        // the checksum count of the population to keep duplicates out. Both
+        // are guarded by heap_mutex, which is also held while replacing a
+        // team. Counts are erased at zero, so the map only holds checksums
+        // of the population and is looked up without inserting.
+        std::vector<std::pair<float, size_t>> heap(pop_size);
+        std::unordered_map<Crc32, size_t> checksum_counts;
+        for (size_t i = 0; i < pop_size; i++) {
+            heap[i] = {teams[i]->score(), i};
+            checksum_counts[teams[i]->checksum()]++;
+        }
+        std::make_heap(begin(heap), end(heap));
+        std::mutex heap_mutex;
+
+        // A team is read under its slot mutex; its score can be read
+        // without.
+        std::vector<std::mutex> slot_mutexes(pop_size);
+        std::unique_ptr<std::atomic<float>[]> scores(
+            new std::atomic<float>[pop_size]);
+        for (size_t i = 0; i < pop_size; i++) {
+            scores[i] = teams[i]->score();
+        }
+
+        // Children scoring above the worst team can be cut off, as in
+        // score().
+        bool const can_cut_off = OPTIONS.collision_penalty >= 0;
+        std::atomic<float> worst_score(heap.front().first);
+
+        mutation_records_.resize(n_children);
+        std::atomic<size_t> n_started(0), n_replaced(0);
+
+        #pragma omp parallel
+        {
+            // Parents are O(1) copies that share nodes, so a slot is only
+            // locked while taking them.
+            auto const take_copy = [&](size_t const i) {
+                std::lock_guard<std::mutex> lock(slot_mutexes[i]);
+                return teams[i]->clone();
+            };
+            auto const copy_from = [&](NodeTeamSP& copy, size_t const i) {
+                std::lock_guard<std::mutex> lock(slot_mutexes[i]);
+                copy->copy(*teams[i]);
+            };
+            // Binary tournament.
+            auto const pick_parent = [&](random::Stream& seed) {
+                size_t const a = random::get_dice(pop_size, seed);
+                size_t const b = random::get_dice(pop_size, seed);
+                return scores[a] < scores[b] ? a : b;
+            };
+
+            NodeTeamSP child = take_copy(0);
+            NodeTeamSP mother = take_copy(0);
+            NodeTeamSP father = take_copy(0);
+
+            scoring::PointBatch batch(batch_.centered_paths());
+
+            for (size_t i = n_started++; i < n_children; i = n_started++) {
+                // Keyed by child so that the draws do not depend on which
+                // thread makes it.
+                child->seed_ = stream_of(i);
+                copy_from(mother, pick_parent(child->seed_));
+                copy_from(father, pick_parent(child->seed_));
+                auto& record = mutation_records_[i];
+                child->evolve(*mother, *father, scheduler_, record);
+                score_alone(*child,
+                            batch,
+                            can_cut_off ? worst_score.load() : INFINITY);
+                record.child_score = child->score();
+
+                if (not (child->score() < worst_score)) {
+                    continue;
+                }
+
+                std::lock_guard<std::mutex> heap_lock(heap_mutex);
+                auto const [worst, worst_id] = heap.front();
+                if (not (child->score() < worst) or
+                        checksum_counts.count(child->checksum())) {
+                    continue;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(slot_mutexes[worst_id]);
+                    std::swap(teams[worst_id], child);
+                    scores[worst_id] = teams[worst_id]->score();
+                }
+
+                // child now holds the replaced team, to be overwritten by
+                // the next evolve().
+                if (--checksum_counts[child->checksum()] == 0) {
+                    checksum_counts.erase(child->checksum());
+                }
+                checksum_counts[teams[worst_id]->checksum()]++;
+
+                std::pop_heap(begin(heap), end(heap));
+                heap.back() = {teams[worst_id]->score(), worst_id};
+                std::push_heap(begin(heap), end(heap));
+                worst_score = heap.front().first;
+                n_replaced++;
+            }
+        }
+
+        generation_++;
+
+        print_mutation_ratios(mutation_records_, 0);
+        scheduler_.update(mutation_records_);
+        mutation_records_.clear();
+        JUtil.info("Replaced %zu of %zu teams\n",
+                   n_replaced.load(), pop_size);
+    }
+    #pragma omp atomic
+    InputManager::ga_times().evolve_time +=
+        TIMING_END("steady state evolution", evolve_start_time);
+}
+
+void Population::score() {
+    TIMING_START(score_start_time);
+    {
+        JUtil.info("Scoring population...\n");
+
+        // Survivors were copied along with their scores, so only the rest of
+        // the population needs scoring.
+        size_t const pop_size = cutoffs_.pop_size;
+        std::vector<size_t> sizes(pop_size, 0);
+        std::vector<uint8_t> prepared(pop_size, 0);
+
+        OMP_PAR_FOR
+        for (size_t rank = cutoffs_.survivors; rank < pop_size; rank++) {
+            auto& team = front_buffer_->at(rank);
+            if (team->prepare_score()) {
+                prepared[rank] = 1;
+                sizes[rank] = team->size();
+            }
+        }
+
+        // Pack all point lists into one buffer and score them in one go.
+        batch_.resize(sizes);
+        batch_.set_cutoff(survivor_cutoff(*front_buffer_, cutoffs_.survivors));
+
+        OMP_PAR_FOR
+        for (size_t rank = cutoffs_.survivors; rank < pop_size; rank++) {
+            if (prepared[rank]) {
+                front_buffer_->at(rank)->pack_points(batch_, rank);
+            }
+        }
+
+        scoring::score_aligned_batch(batch_);
+
+        OMP_PAR_FOR
+        for (size_t rank = cutoffs_.survivors; rank < pop_size; rank++) {
+            if (prepared[rank]) {
+                front_buffer_->at(rank)->finish_score(batch_, rank);
+            }
+        }
+
+        // Children made by evolve() are now scored, so their mutations can
+        // be paid off.
+        if (mutation_records_.size() == cutoffs_.non_survivors) {
+            for (size_t rank = cutoffs_.survivors; rank < pop_size; rank++) {
+                mutation_records_[rank - cutoffs_.survivors].child_score =
+                    front_buffer_->at(rank)->score();
+            }
+            scheduler_.update(mutation_records_);
+            mutation_records_.clear();
+        }
+    }
+    #pragma omp atomic
+    InputManager::ga_times().score_time +=
+        TIMING_END("scoring", score_start_time);
+}
+
 void Population::rank() {
     TIMING_START(rank_start_time);
     {
         JUtil.info("Ranking population...\n");
 
-        std::sort(begin(*front_buffer_),
-                  end(*front_buffer_),
-                  NodeTeam::SPLess());
+        // Teams rejected in score() carry a lower bound above the survivor
+        // cutoff, so they sort behind every team that can survive.
+
+        // Only the prefix that select() and the output heap look at is
+        // sorted. Survivors carried over from the last generation are already
+        // in order, so they are merged with the best of the new teams.
+        size_t const pop_size = front_buffer_->size();
+        size_t const n_carried = std::min(cutoffs_.survivors, pop_size);
+        n_ranked_ = std::min(pop_size,
+                             std::max(cutoffs_.survivors, OPTIONS.keep_n));
+
+        ranking_.resize(pop_size);
+
+        OMP_PAR_FOR
+        for (size_t i = 0; i < pop_size; i++) {
+            ranking_[i] = {front_buffer_->at(i)->score(), i};
+        }
+
+        auto const carried_end = begin(ranking_) + n_carried;
+        if (not std::is_sorted(begin(ranking_), carried_end)) {
+            std::sort(begin(ranking_), carried_end);
+        }
+
+        size_t const n_best_new =
+            std::min(n_ranked_, pop_size - n_carried);
+        auto const best_new_end = carried_end + n_best_new;
+        if (best_new_end != end(ranking_)) {
+            std::nth_element(carried_end, best_new_end, end(ranking_));
+        }
+        std::sort(carried_end, best_new_end);
+        std::inplace_merge(begin(ranking_), carried_end, best_new_end);
+
+        // Keep the worst team at the back for generation stats.
+        if (n_ranked_ < pop_size) {
+            std::iter_swap(std::max_element(begin(ranking_) + n_ranked_,
+                                             end(ranking_)),
+                           end(ranking_) - 1);
+        }
+
+        ranked_teams_.resize(pop_size);
+
+        OMP_PAR_FOR
+        for (size_t i = 0; i < pop_size; i++) {
+            ranked_teams_[i] = std::move(front_buffer_->at(ranking_[i].second));
+        }
+
+        std::swap(*front_buffer_, ranked_teams_);
     }
+    #pragma omp atomic
     InputManager::ga_times().rank_time +=
         TIMING_END("ranking", rank_start_time);
 }
 
 void Population::select() {
     /*
-     * Minimize same-ness within survivors by using hashmap where crc is key
-     * and cloned pointer is value.
+     * Minimize same-ness within survivors by keeping only the best ranked
+     * team of each checksum.
      */
 
     TIMING_START(start_time_select);
     {
         JUtil.info("Selecting population...\n");
 
-        std::unordered_map<Crc32, NodeTeamSP> crc_map;
-        size_t unique_count = 0;
+        size_t const pop_size = front_buffer_->size();
+        std::vector<uint8_t> is_first(pop_size, 0);
 
-        // We don't want parallelism here because the low indexes must be
-        // prioritized.
-        for (auto& team : *front_buffer_) {
-            Crc32 const crc = team->checksum();
-            if (crc_map.find(crc) == end(crc_map)) {
-                // Record a new team
-                crc_map[crc] = team->clone();
-                unique_count++;
+        auto const find_first_ranks = [&]() {
+            FirstRankTable first_ranks(pop_size);
 
-                if (unique_count >= CUTOFFS.survivors) {
-                    break;
-                }
+            OMP_PAR_FOR
+            for (size_t rank = 0; rank < pop_size; rank++) {
+                first_ranks.insert(front_buffer_->at(rank)->checksum(), rank);
             }
-        }
 
-        // Insert map-value-indexed individual back into population
-        size_t pop_index = 0;
-        for (auto& [key, val] : crc_map) {
-            front_buffer_->at(pop_index) = std::move(val);
-            pop_index++;
+            OMP_PAR_FOR
+            for (size_t rank = 0; rank < pop_size; rank++) {
+                Crc32 const crc = front_buffer_->at(rank)->checksum();
+                is_first[rank] = first_ranks.first_rank(crc) == rank;
+            }
+        };
+
+        find_first_ranks();
+
+        // If duplicates leave too few unique teams in the prefix sorted by
+        // rank(), sort the rest too. It scores no better than the prefix, so
+        // the prefix stays in place.
+        size_t const n_ranked_unique = std::count(
+                                           begin(is_first),
+                                           begin(is_first) + n_ranked_,
+                                           1);
+        if (n_ranked_unique < cutoffs_.survivors and n_ranked_ < pop_size) {
+            std::sort(begin(*front_buffer_) + n_ranked_,
+                      end(*front_buffer_),
+                      NodeTeam::SPLess());
+            n_ranked_ = pop_size;
+            find_first_ranks();
         }
 
-        // Sort survivors
-        std::sort(begin(*front_buffer_),
-                  begin(*front_buffer_) + unique_count,
-                  NodeTeam::SPLess());
+        // Move unique teams to the front in rank order, so survivors stay
+        // sorted. Each swap sends a duplicate or an already passed team
+        // backwards, never an unvisited unique one.
+        size_t unique_count = 0;
+        for (size_t rank = 0;
+                rank < pop_size and unique_count < cutoffs_.survivors;
+                rank++) {
+            if (is_first[rank]) {
+                std::swap(front_buffer_->at(unique_count),
+                          front_buffer_->at(rank));
+                unique_count++;
+            }
+        }
     }
+    #pragma omp atomic
     InputManager::ga_times().select_time +=
         TIMING_END("variety selection", start_time_select);
 }
 
+void Population::refine() {
+    size_t const survivors = std::min(cutoffs_.survivors,
+                                      front_buffer_->size());
+    size_t const n_elites = std::min(OPTIONS.ga_local_search_elites,
+                                     survivors);
+    if (n_elites == 0 or OPTIONS.ga_local_search_budget == 0) {
+        return;
+    }
+
+    TIMING_START(refine_start_time);
+    {
+        JUtil.info("Refining %zu survivors...\n", n_elites);
+
+        // Searches run on copies, which only replace their survivors below.
+        // Neighbors of larger teams cost more to build and score.
+        NodeTeams refined(n_elites);
+        auto const times = parallel::run_tasks(
+                               n_elites,
+        [&](size_t const rank) {
+            return 1.0f + front_buffer_->at(rank)->size();
+        },
+        [&](size_t const rank) {
+            auto team = front_buffer_->at(rank)->clone();
+            // Keyed past the ranks of evolve(), so that no child shares the
+            // draws.
+            team->seed_ = stream_of(cutoffs_.pop_size + rank);
+            if (team->local_search(OPTIONS.ga_local_search_budget)) {
+                team->home_node_ = front_buffer_->at(rank)->home_node_;
+                refined[rank] = std::move(team);
+            }
+        });
+        times.print("refinement");
+
+        // Keep survivor checksums distinct, as select() does. Going by rank,
+        // two survivors refined into the same team leave it to the better.
+        std::unordered_set<Crc32> checksums;
+        for (size_t rank = 0; rank < survivors; rank++) {
+            checksums.insert(front_buffer_->at(rank)->checksum());
+        }
+
+        size_t n_improved = 0;
+        for (size_t rank = 0; rank < n_elites; rank++) {
+            auto& team = refined[rank];
+            if (team and checksums.insert(team->checksum()).second) {
+                checksums.erase(front_buffer_->at(rank)->checksum());
+                std::swap(front_buffer_->at(rank), team);
+                n_improved++;
+            }
+        }
+
+        // Improved survivors may now rank above others.
+        std::stable_sort(begin(*front_buffer_),
+                         begin(*front_buffer_) + survivors,
+                         NodeTeam::SPLess());
+
+        JUtil.info("Local search improved %zu of %zu survivors\n",
+                   n_improved, n_elites);
+    }
+    #pragma omp atomic
+    InputManager::ga_times().refine_time +=
+        TIMING_END("refinement", refine_start_time);
+}
+
+void Population::immigrate(NodeTeams const& migrants) {
+    auto const survivors_begin = begin(*front_buffer_);
+    auto const survivors_end = survivors_begin +
+                               std::min(cutoffs_.survivors,
+                                        front_buffer_->size());
+
+    for (auto const& migrant : migrants) {
+        auto& worst = *(survivors_end - 1);
+        if (not (migrant->score() < worst->score())) {
+            continue;
+        }
+
+        // Keep survivor checksums distinct, as select() does.
+        bool const is_duplicate = std::any_of(
+                                      survivors_begin,
+                                      survivors_end,
+        [&migrant](NodeTeamSP const & team) {
+            return team->checksum() == migrant->checksum();
+        });
+        if (is_duplicate) {
+            continue;
+        }
+
+        worst->copy(*migrant);
+
+        // Move it up to its rank.
+        auto const rank = std::upper_bound(survivors_begin,
+                                           survivors_end - 1,
+                                           worst,
+                                           NodeTeam::SPLess());
+        std::rotate(rank, survivors_end - 1, survivors_end);
+    }
+}
+
 void Population::swap_buffer() {
     NodeTeams const* tmp = back_buffer_;
     back_buffer_ = front_buffer_;
@@ -15,7 +15,7 @@ namespace elfin {
 /* accessors */
 ProtoLink const& ProtoTerm::pick_random_link(
     TermType const term,
-    uint32_t& seed) const
+    random::Stream& seed) const
 {
     if (term == TermType::N) {
         return *n_roulette_.draw(seed);
@@ -169,6 +169,9 @@ void ProtoTerm::configure(
         c_roulette_.push_back(c_cpd, link_ptr);
     }
 
+    n_roulette_.build_alias_table();
+    c_roulette_.build_alias_table();
+
     //
     // Compute checksum for terminal, which will be used in computing
     // candidate checksum
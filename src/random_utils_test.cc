@@ -1,7 +1,10 @@
 #include "random_utils.h"
 
+#include <cmath>
+
 #include "omp.h"
 
+#include "roulette.h"
 #include "test_stat.h"
 #include "jutil.h"
 
@@ -15,53 +18,135 @@ TestStat test() {
 
     size_t const N = 37189;
     size_t const dice_max = 13377331;
-    uint32_t const test_seed = 0xeeee;
+    uint64_t const test_key = 0xeeee;
+
+    // Test against the known answers of Philox4x32-10.
+    {
+        ts.tests++;
+        Block const zeros = philox(0, 0);
+        if (zeros != Block({0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8})) {
+            ts.errors++;
+            JUtil.error("philox() does not match Philox4x32-10: "
+                        "%08x %08x %08x %08x\n",
+                        zeros[0], zeros[1], zeros[2], zeros[3]);
+        }
+    }
 
     // Test single thread consistency.
     {
         ts.tests++;
-        auto seed = test_seed;
+        Stream seed(test_key);
         for (size_t i = 0; i < N; ++i) {
             auto seed2 = seed;
-            auto const v1 = rand_r(&seed);
-            auto const v2 = rand_r(&seed2);
+            auto const v1 = seed.next();
+            auto const v2 = seed2.next();
             if (v1 != v2) {
                 ts.errors++;
-                JUtil.error("rand_r() inconsistent at #%zu: %zu vs %zu\n",
+                JUtil.error("Stream inconsistent at #%zu: %u vs %u\n",
                             i, v1, v2);
                 break;
             }
         }
     }
 
-    // Test multi-threaded consistency.
+    // Test that batched and skipped draws match single draws.
     {
-        // Set up OMP.
-        omp_set_dynamic(0);                 // Explicitly disable dynamic thread teams.
-        size_t const num_threads = 9;       // Use a weird number.
-        omp_set_num_threads(num_threads);   // Use exactly N threads.
+        std::vector<uint32_t> singles(N);
+        Stream seed(test_key);
+        for (auto& v : singles) {
+            v = seed.next();
+        }
 
-        auto seed = test_seed;
-        std::vector<uint32_t> seeds(N, 0);
-        for (size_t i = 0; i < N; ++i) {
-            seeds[i] = rand_r(&seed);
+        ts.tests++;
+        std::vector<uint32_t> batch(N);
+        Stream batch_seed(test_key);
+        batch_seed.next();  // Start out of step with blocks.
+        batch[0] = singles[0];
+        batch_seed.fill(&batch[1], N - 1);
+        if (batch != singles or batch_seed != seed) {
+            ts.errors++;
+            JUtil.error("Stream::fill() differs from Stream::next()\n");
+        }
+
+        ts.tests++;
+        for (size_t i : {(size_t) 1, (size_t) 4, (size_t) 4097, N - 1}) {
+            if (Stream(test_key, i).next() != singles[i]) {
+                ts.errors++;
+                JUtil.error("Stream at draw #%zu differs from its draw\n", i);
+                break;
+            }
         }
+    }
 
-        std::vector<size_t> vals1(N, 0);
-        #pragma omp parallel for
+    // Test that dice stay within their ceiling and reach both ends.
+    {
+        ts.tests++;
+        Stream seed(test_key);
+        size_t const ceiling = 7;
+        std::vector<size_t> counts(ceiling + 1, 0);
         for (size_t i = 0; i < N; ++i) {
-            auto seed_copy = seeds.at(i);
-            vals1[i] = get_dice(dice_max, seed_copy);
+            counts.at(std::min(get_dice(ceiling, seed), ceiling))++;
         }
+        if (counts.at(0) == 0 or
+                counts.at(ceiling - 1) == 0 or
+                counts.at(ceiling) != 0) {
+            ts.errors++;
+            JUtil.error("get_dice() out of range or missing ends\n");
+        }
+    }
+
+    // Test that Roulette draws in proportion to exact probabilities, and
+    // never draws items of probability 0.
+    {
+        std::vector<float> const probs = {0.5f, 0, 3.25f, 1, 0, 0.25f};
+        Roulette<size_t> roulette;
+        for (size_t i = 0; i < probs.size(); ++i) {
+            roulette.push_back(probs[i], i);
+        }
+        roulette.build_alias_table();
 
-        std::vector<size_t> vals2(N, 0);
-        #pragma omp parallel for
+        Stream seed(test_key);
+        std::vector<size_t> counts(probs.size(), 0);
         for (size_t i = 0; i < N; ++i) {
-            auto seed_copy = seeds.at(i);
-            vals2[i] = get_dice(dice_max, seed_copy);
+            counts.at(roulette.draw(seed))++;
+        }
+
+        ts.tests++;
+        for (size_t i = 0; i < probs.size(); ++i) {
+            float const expected = probs[i] / roulette.total();
+            float const actual = (float) counts[i] / N;
+            if (std::abs(actual - expected) > 0.01f or
+                    (probs[i] == 0 and counts[i] != 0)) {
+                ts.errors++;
+                JUtil.error("Roulette drew #%zu at %f instead of %f\n",
+                            i, actual, expected);
+                break;
+            }
         }
+    }
+
+    // Test multi-threaded consistency. Values of streams keyed by index
+    // must not depend on the number of threads.
+    {
+        // Set up OMP.
+        omp_set_dynamic(0);                 // Explicitly disable dynamic thread teams.
+
+        auto const draw_all = [&](size_t const num_threads) {
+            omp_set_num_threads(num_threads);   // Use exactly N threads.
+
+            std::vector<size_t> vals(N, 0);
+            #pragma omp parallel for
+            for (size_t i = 0; i < N; ++i) {
+                Stream seed(derive(test_key, i));
+                vals[i] = get_dice(dice_max, seed);
+            }
+            return vals;
+        };
+
+        std::vector<size_t> const vals1 = draw_all(1);
+        std::vector<size_t> const vals2 = draw_all(9);  // Use a weird number.
 
-        // Check that all random values originated from the same seeds are
+        // Check that all random values originated from the same keys are
         // identical.
         ts.tests++;
         for (size_t i = 0; i < N; ++i) {
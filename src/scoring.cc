@@ -1,8 +1,11 @@
 #include "scoring.h"
 
 #include <numeric>
+#include <algorithm>
 
 #include "debug_utils.h"
+#include "parallel_utils.h"
+#include "input_manager.h"
 #include "test_data.h"
 
 namespace elfin {
@@ -10,18 +13,14 @@ namespace elfin {
 namespace scoring {
 
 
-float aligned_rms(V3fList const& mobile,
-                  V3fList const& ref)
-{
-    size_t const n = mobile.size();
-    size_t const ref_n = ref.size();
-
-    // Check sample sizes.
-    DEBUG_NOMSG(n < 1);
-    DEBUG_NOMSG(ref_n < 1);
-    DEBUG_NOMSG(n != ref_n);
+// Set by init() from OPTIONS.rmsd_engine.
+static bool use_qcp = false;
 
-    double e0 = 0.0f;
+// Eigenvalue half of Rosetta's RMS-only Kabsch: the residual after optimal
+// superposition, given the correlation matrix r of the centered point lists
+// and e0, the sum of their squared distances to their centers.
+float rosetta_rms_from_correlation(double const r[3][3], double const e0)
+{
     double h = 0.0f;
     double g = 0.0f;
     double cth = 0.0f;
@@ -29,40 +28,10 @@ float aligned_rms(V3fList const& mobile,
     double sqrth = 0.0f;
     double det = 0.0f;
     double sigma = 0.0f;
-    double xc[3] = { 0 }, yc[3] = { 0 };
-    double r[3][3] = {0};
     double e[3] = {0};
     double rr[6] = {0};
     double sqrt3 = 1.73205080756888;
 
-    // Compute centers for point vectors x, y.
-    for (size_t i = 0; i < n; ++i) {
-        xc[0] += mobile[i][0];
-        xc[1] += mobile[i][1];
-        xc[2] += mobile[i][2];
-
-        yc[0] += ref[i][0];
-        yc[1] += ref[i][1];
-        yc[2] += ref[i][2];
-    }
-
-    for (size_t i = 0; i < 3; ++i) {
-        xc[i] = xc[i] / n;
-        yc[i] = yc[i] / n;
-    }
-
-    // Compute e0 and matrix r.
-    for (size_t m = 0; m < n; m++) {
-        for (size_t i = 0; i < 3; ++i) {
-            double const d = ref[m][i] - yc[i];
-            e0 += (mobile[m][i] - xc[i]) * (mobile[m][i] - xc[i]) + \
-                  (d * d);
-            for (size_t j = 0; j < 3; j++) {
-                r[i][j] += d * (mobile[m][j] - xc[j]);
-            }
-        }
-    }
-
     // Compute determinat of matrix r.
     det = r[0][0] * ( r[1][1] * r[2][2] - r[1][2] * r[2][1] )
           - r[0][1] * ( r[1][0] * r[2][2] - r[1][2] * r[2][0] )
@@ -121,6 +90,433 @@ float aligned_rms(V3fList const& mobile,
     return rms;
 }
 
+double det3(double const a[3][3]) {
+    return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+           - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+           + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+}
+
+double det4(double const a[4][4]) {
+    // Cofactor expansion along the first row.
+    double res = 0.0;
+    for (size_t col = 0; col < 4; ++col) {
+        double minor[3][3];
+        for (size_t i = 1; i < 4; ++i) {
+            for (size_t j = 0, mj = 0; j < 4; ++j) {
+                if (j != col) minor[i - 1][mj++] = a[i][j];
+            }
+        }
+        res += (col % 2 ? -1 : 1) * a[0][col] * det3(minor);
+    }
+    return res;
+}
+
+// Horn's symmetric quaternion matrix k for the correlation matrix r, whose
+// largest eigenvalue equals the sum of singular values (sign-corrected) that
+// Kabsch would find.
+void build_quaternion_matrix(double const r[3][3], double k[4][4]) {
+    // Horn's S(a, b) sums mobile_a * ref_b, i.e. r transposed.
+    double const sxx = r[0][0], sxy = r[1][0], sxz = r[2][0];
+    double const syx = r[0][1], syy = r[1][1], syz = r[2][1];
+    double const szx = r[0][2], szy = r[1][2], szz = r[2][2];
+
+    double const q[4][4] = {
+        {sxx + syy + szz, syz - szy, szx - sxz, sxy - syx},
+        {syz - szy, sxx - syy - szz, sxy + syx, szx + sxz},
+        {szx - sxz, sxy + syx, -sxx + syy - szz, syz + szy},
+        {sxy - syx, szx + sxz, syz + szy, -sxx - syy + szz}
+    };
+    std::copy(&q[0][0], &q[0][0] + 16, &k[0][0]);
+}
+
+// Theobald's QCP: Newton's method on the characteristic polynomial of k,
+//   x^4 + c2 x^2 + c1 x + c0,
+// starting from e0 / 2, which bounds the largest eigenvalue from above.
+double qcp_max_eigenvalue(double const r[3][3],
+                          double const k[4][4],
+                          double const e0)
+{
+    double sq_norm = 0.0;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            sq_norm += r[i][j] * r[i][j];
+        }
+    }
+
+    double const c2 = -2.0 * sq_norm;
+    double const c1 = -8.0 * det3(r);
+    double const c0 = det4(k);
+
+    double lambda = e0 / 2.0;
+    for (size_t i = 0; i < 50; ++i) {
+        double const lambda2 = lambda * lambda;
+        double const b = (lambda2 + c2) * lambda;
+        double const a = b + c1;
+        double const delta = (a * lambda + c0) / (2.0 * lambda2 * lambda + b + a);
+        lambda -= delta;
+        if (not (std::abs(delta) > 1e-14 * std::abs(lambda))) {
+            break;
+        }
+    }
+
+    return lambda;
+}
+
+float qcp_rms_from_correlation(double const r[3][3], double const e0) {
+    double k[4][4];
+    build_quaternion_matrix(r, k);
+
+    float const rms = e0 - 2.0 * qcp_max_eigenvalue(r, k, e0);
+
+    if (rms < 0.0 ) {
+        return 0.0;
+    }
+
+    return rms;
+}
+
+float rms_from_correlation(double const r[3][3], double const e0) {
+    return use_qcp ?
+           qcp_rms_from_correlation(r, e0) :
+           rosetta_rms_from_correlation(r, e0);
+}
+
+// QCP counterpart of _rosetta_kabsch_align(): the rotation comes from the
+// eigenvector of the largest eigenvalue, read off the adjugate of
+// (k - lambda * I).
+void qcp_kabsch_align(V3fList const& mobile,
+                      V3fList const& ref,
+                      elfin::Mat3f& rot,
+                      Vector3f& tran)
+{
+    size_t const n = mobile.size();
+
+    // Check sample sizes.
+    DEBUG_NOMSG(n < 1);
+    DEBUG_NOMSG(n != ref.size());
+
+    double xc[3] = { 0 }, yc[3] = { 0 };
+    for (size_t m = 0; m < n; ++m) {
+        for (size_t i = 0; i < 3; ++i) {
+            xc[i] += mobile[m][i];
+            yc[i] += ref[m][i];
+        }
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        xc[i] = xc[i] / n;
+        yc[i] = yc[i] / n;
+    }
+
+    double e0 = 0.0;
+    double r[3][3] = {0};
+    for (size_t m = 0; m < n; ++m) {
+        for (size_t i = 0; i < 3; ++i) {
+            double const d = ref[m][i] - yc[i];
+            e0 += (mobile[m][i] - xc[i]) * (mobile[m][i] - xc[i]) + d * d;
+            for (size_t j = 0; j < 3; ++j) {
+                r[i][j] += d * (mobile[m][j] - xc[j]);
+            }
+        }
+    }
+
+    double k[4][4];
+    build_quaternion_matrix(r, k);
+    double const lambda = qcp_max_eigenvalue(r, k, e0);
+    for (size_t i = 0; i < 4; ++i) {
+        k[i][i] -= lambda;
+    }
+
+    // Any row of the adjugate is parallel to the eigenvector; take the
+    // longest one for numerical stability.
+    double q[4] = {1, 0, 0, 0};
+    double best_sq_norm = 0.0;
+    for (size_t row = 0; row < 4; ++row) {
+        double v[4];
+        double sq_norm = 0.0;
+        for (size_t col = 0; col < 4; ++col) {
+            double minor[3][3];
+            for (size_t i = 0, mi = 0; i < 4; ++i) {
+                if (i == row) continue;
+                for (size_t j = 0, mj = 0; j < 4; ++j) {
+                    if (j != col) minor[mi][mj++] = k[i][j];
+                }
+                mi++;
+            }
+            v[col] = ((row + col) % 2 ? -1 : 1) * det3(minor);
+            sq_norm += v[col] * v[col];
+        }
+
+        if (sq_norm > best_sq_norm) {
+            best_sq_norm = sq_norm;
+            std::copy(v, v + 4, q);
+        }
+    }
+
+    // Identity if the eigenvector is degenerate (e.g. collinear points).
+    if (best_sq_norm > 0.0) {
+        double const norm = sqrt(best_sq_norm);
+        for (size_t i = 0; i < 4; ++i) {
+            q[i] /= norm;
+        }
+    }
+
+    double const q00 = q[0] * q[0], q11 = q[1] * q[1];
+    double const q22 = q[2] * q[2], q33 = q[3] * q[3];
+    double const q01 = q[0] * q[1], q02 = q[0] * q[2], q03 = q[0] * q[3];
+    double const q12 = q[1] * q[2], q13 = q[1] * q[3], q23 = q[2] * q[3];
+
+    rot[0][0] = q00 + q11 - q22 - q33;
+    rot[0][1] = 2 * (q12 - q03);
+    rot[0][2] = 2 * (q13 + q02);
+    rot[1][0] = 2 * (q12 + q03);
+    rot[1][1] = q00 - q11 + q22 - q33;
+    rot[1][2] = 2 * (q23 - q01);
+    rot[2][0] = 2 * (q13 - q02);
+    rot[2][1] = 2 * (q23 + q01);
+    rot[2][2] = q00 - q11 - q22 + q33;
+
+    // Compute t.
+    for (size_t i = 0; i < 3; ++i) {
+        tran[i] = ((yc[i] - rot[i][0] * xc[0]) - rot[i][1] * xc[1]) -
+                  rot[i][2] * xc[2];
+    }
+}
+
+float aligned_rms(V3fList const& mobile,
+                  V3fList const& ref)
+{
+    size_t const n = mobile.size();
+    size_t const ref_n = ref.size();
+
+    // Check sample sizes.
+    DEBUG_NOMSG(n < 1);
+    DEBUG_NOMSG(ref_n < 1);
+    DEBUG_NOMSG(n != ref_n);
+
+    double e0 = 0.0f;
+    double xc[3] = { 0 }, yc[3] = { 0 };
+    double r[3][3] = {0};
+
+    // Compute centers for point vectors x, y.
+    for (size_t i = 0; i < n; ++i) {
+        xc[0] += mobile[i][0];
+        xc[1] += mobile[i][1];
+        xc[2] += mobile[i][2];
+
+        yc[0] += ref[i][0];
+        yc[1] += ref[i][1];
+        yc[2] += ref[i][2];
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        xc[i] = xc[i] / n;
+        yc[i] = yc[i] / n;
+    }
+
+    // Compute e0 and matrix r.
+    for (size_t m = 0; m < n; m++) {
+        for (size_t i = 0; i < 3; ++i) {
+            double const d = ref[m][i] - yc[i];
+            e0 += (mobile[m][i] - xc[i]) * (mobile[m][i] - xc[i]) + \
+                  (d * d);
+            for (size_t j = 0; j < 3; j++) {
+                r[i][j] += d * (mobile[m][j] - xc[j]);
+            }
+        }
+    }
+
+    return rms_from_correlation(r, e0);
+}
+
+// aligned_rms() against two references at once, e.g. a path and its reverse.
+// The mobile center and its share of e0 are computed once, and both
+// correlation matrices are built in the same pass over the mobile points.
+void aligned_rms(V3fList const& mobile,
+                 V3fList const& ref_a,
+                 V3fList const& ref_b,
+                 float& rms_a,
+                 float& rms_b)
+{
+    size_t const n = mobile.size();
+
+    // Check sample sizes.
+    DEBUG_NOMSG(n < 1);
+    DEBUG_NOMSG(n != ref_a.size());
+    DEBUG_NOMSG(n != ref_b.size());
+
+    double xc[3] = { 0 }, yc_a[3] = { 0 }, yc_b[3] = { 0 };
+    for (size_t m = 0; m < n; ++m) {
+        for (size_t i = 0; i < 3; ++i) {
+            xc[i] += mobile[m][i];
+            yc_a[i] += ref_a[m][i];
+            yc_b[i] += ref_b[m][i];
+        }
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        xc[i] = xc[i] / n;
+        yc_a[i] = yc_a[i] / n;
+        yc_b[i] = yc_b[i] / n;
+    }
+
+    double sq_sum = 0.0, e0_a = 0.0, e0_b = 0.0;
+    double r_a[3][3] = {0}, r_b[3][3] = {0};
+    for (size_t m = 0; m < n; ++m) {
+        double x[3], d_a[3], d_b[3];
+        for (size_t i = 0; i < 3; ++i) {
+            x[i] = mobile[m][i] - xc[i];
+            d_a[i] = ref_a[m][i] - yc_a[i];
+            d_b[i] = ref_b[m][i] - yc_b[i];
+            sq_sum += x[i] * x[i];
+            e0_a += d_a[i] * d_a[i];
+            e0_b += d_b[i] * d_b[i];
+        }
+
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                r_a[i][j] += d_a[i] * x[j];
+                r_b[i][j] += d_b[i] * x[j];
+            }
+        }
+    }
+
+    rms_a = rms_from_correlation(r_a, sq_sum + e0_a);
+    rms_b = rms_from_correlation(r_b, sq_sum + e0_b);
+}
+
+// Sum of squared distances of a structure-of-arrays point list to its center.
+double centered_sq_sum(float const* const xs,
+                       float const* const ys,
+                       float const* const zs,
+                       size_t const n)
+{
+    double xc0 = 0, xc1 = 0, xc2 = 0;
+    #pragma omp simd reduction(+:xc0, xc1, xc2)
+    for (size_t m = 0; m < n; ++m) {
+        xc0 += xs[m];
+        xc1 += ys[m];
+        xc2 += zs[m];
+    }
+    xc0 /= n;
+    xc1 /= n;
+    xc2 /= n;
+
+    double sq_sum = 0;
+    #pragma omp simd reduction(+:sq_sum)
+    for (size_t m = 0; m < n; ++m) {
+        double const x0 = xs[m] - xc0;
+        double const x1 = ys[m] - xc1;
+        double const x2 = zs[m] - xc2;
+        sq_sum += x0 * x0 + x1 * x1 + x2 * x2;
+    }
+
+    return sq_sum;
+}
+
+// Lower bound on the residual e0 - 2 * d of aligning two centered point lists
+// with the given sums of squares. d is at most the sum of singular values of
+// the correlation matrix, which Cauchy-Schwarz bounds by
+// sqrt(sq_sum_x * sq_sum_y). The bound is the squared gap between the radii
+// of gyration, scaled by the point count.
+double residual_lower_bound(double const sq_sum_x, double const sq_sum_y) {
+    double const gap = sqrt(sq_sum_x) - sqrt(sq_sum_y);
+    return gap * gap;
+}
+
+// aligned_rms() for a structure-of-arrays mobile against a CenteredRef of the
+// same size.
+float aligned_rms(float const* const xs,
+                  float const* const ys,
+                  float const* const zs,
+                  CenteredRef const& ref)
+{
+    size_t const n = ref.xs.size();
+    DEBUG_NOMSG(n < 1);
+
+    double xc0 = 0, xc1 = 0, xc2 = 0;
+    #pragma omp simd reduction(+:xc0, xc1, xc2)
+    for (size_t m = 0; m < n; ++m) {
+        xc0 += xs[m];
+        xc1 += ys[m];
+        xc2 += zs[m];
+    }
+    xc0 /= n;
+    xc1 /= n;
+    xc2 /= n;
+
+    double e0 = ref.sq_sum;
+    double r00 = 0, r01 = 0, r02 = 0;
+    double r10 = 0, r11 = 0, r12 = 0;
+    double r20 = 0, r21 = 0, r22 = 0;
+    #pragma omp simd reduction(+:e0, r00, r01, r02, r10, r11, r12, r20, r21, r22)
+    for (size_t m = 0; m < n; ++m) {
+        double const x0 = xs[m] - xc0;
+        double const x1 = ys[m] - xc1;
+        double const x2 = zs[m] - xc2;
+        double const d0 = ref.xs[m];
+        double const d1 = ref.ys[m];
+        double const d2 = ref.zs[m];
+
+        e0 += x0 * x0 + x1 * x1 + x2 * x2;
+        r00 += d0 * x0; r01 += d0 * x1; r02 += d0 * x2;
+        r10 += d1 * x0; r11 += d1 * x1; r12 += d1 * x2;
+        r20 += d2 * x0; r21 += d2 * x1; r22 += d2 * x2;
+    }
+
+    double const r[3][3] = {
+        {r00, r01, r02},
+        {r10, r11, r12},
+        {r20, r21, r22}
+    };
+    return rms_from_correlation(r, e0);
+}
+
+// Fused form of the above for two CenteredRefs of the same size.
+void aligned_rms(float const* const xs,
+                 float const* const ys,
+                 float const* const zs,
+                 CenteredRef const& ref_a,
+                 CenteredRef const& ref_b,
+                 float& rms_a,
+                 float& rms_b)
+{
+    size_t const n = ref_a.xs.size();
+    DEBUG_NOMSG(n < 1);
+    DEBUG_NOMSG(n != ref_b.xs.size());
+
+    double xc0 = 0, xc1 = 0, xc2 = 0;
+    #pragma omp simd reduction(+:xc0, xc1, xc2)
+    for (size_t m = 0; m < n; ++m) {
+        xc0 += xs[m];
+        xc1 += ys[m];
+        xc2 += zs[m];
+    }
+    xc0 /= n;
+    xc1 /= n;
+    xc2 /= n;
+
+    double sq_sum = 0;
+    double r_a[3][3] = {0}, r_b[3][3] = {0};
+    #pragma omp simd reduction(+:sq_sum, r_a[:3][:3], r_b[:3][:3])
+    for (size_t m = 0; m < n; ++m) {
+        double const x[3] = {xs[m] - xc0, ys[m] - xc1, zs[m] - xc2};
+        double const d_a[3] = {ref_a.xs[m], ref_a.ys[m], ref_a.zs[m]};
+        double const d_b[3] = {ref_b.xs[m], ref_b.ys[m], ref_b.zs[m]};
+
+        sq_sum += x[0] * x[0] + x[1] * x[1] + x[2] * x[2];
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                r_a[i][j] += d_a[i] * x[j];
+                r_b[i][j] += d_b[i] * x[j];
+            }
+        }
+    }
+
+    rms_a = rms_from_correlation(r_a, sq_sum + ref_a.sq_sum);
+    rms_b = rms_from_correlation(r_b, sq_sum + ref_b.sq_sum);
+}
+
 float unaligned_rms(V3fList const& mobile,
                     V3fList const& ref)
 {
@@ -145,25 +541,34 @@ float unaligned_rms(V3fList const& mobile,
     return rms;
 }
 
+void init() {
+    use_qcp = OPTIONS.rmsd_engine == "qcp";
+}
+
 void calc_alignment(V3fList const& mobile,
                     V3fList const& ref,
                     elfin::Mat3f& rot,
                     Vector3f& tran)
 {
+    auto const align = use_qcp ? qcp_kabsch_align : _rosetta_kabsch_align;
+
     // Upsample if needed. Also do a bit of checking to avoid unnecessary copying
+    thread_local V3fList resampled;
     size_t const ref_size = ref.size();
     size_t const mobile_size = mobile.size();
     if (ref_size < mobile_size)
     {
-        return _rosetta_kabsch_align(mobile, _upsample(ref, mobile_size), rot, tran);
+        upsample(ref, mobile_size, resampled);
+        return align(mobile, resampled, rot, tran);
     }
     else if (mobile_size < ref_size)
     {
-        return _rosetta_kabsch_align(_upsample(mobile, ref_size), ref, rot, tran);
+        upsample(mobile, ref_size, resampled);
+        return align(resampled, ref, rot, tran);
     }
     else
     {
-        return _rosetta_kabsch_align(mobile, ref, rot, tran);
+        return align(mobile, ref, rot, tran);
     }
 }
 
@@ -178,15 +583,19 @@ float _score(V3fList const& mobile,
         return INFINITY;
 
     // Upsample if needed. Also do a bit of checking to avoid unnecessary copying
+    // Resample into a per-thread scratch list to avoid allocating.
+    thread_local V3fList resampled;
     size_t const ref_size = ref.size();
     size_t const mobile_size = mobile.size();
     if (ref_size < mobile_size)
     {
-        return scoring_func(mobile, _upsample(ref, mobile_size));
+        upsample(ref, mobile_size, resampled);
+        return scoring_func(mobile, resampled);
     }
     else if (mobile_size < ref_size)
     {
-        return scoring_func(_upsample(mobile, ref_size), ref);
+        upsample(mobile, ref_size, resampled);
+        return scoring_func(resampled, ref);
     }
     else
     {
@@ -202,67 +611,354 @@ float score_unaligned(V3fList const& mobile, V3fList const& ref) {
     return _score(mobile, ref, unaligned_rms);
 }
 
-struct SampleSegment
+void score_aligned_pair(V3fList const& mobile,
+                        V3fList const& ref_a,
+                        V3fList const& ref_b,
+                        float& score_a,
+                        float& score_b)
+{
+    size_t const ref_size = ref_a.size();
+    size_t const mobile_size = mobile.size();
+    if (ref_b.size() != ref_size) {
+        score_a = score_aligned(mobile, ref_a);
+        score_b = score_aligned(mobile, ref_b);
+        return;
+    }
+
+    if (mobile_size == 1 and ref_size == 1) {
+        score_a = score_b = 0;
+        return;
+    }
+
+    if (mobile_size <= 1 or ref_size <= 1) {
+        score_a = score_b = INFINITY;
+        return;
+    }
+
+    // Same resampling as _score(), into per-thread scratch lists.
+    thread_local V3fList resampled_a, resampled_b;
+    if (ref_size < mobile_size)
+    {
+        upsample(ref_a, mobile_size, resampled_a);
+        upsample(ref_b, mobile_size, resampled_b);
+        aligned_rms(mobile, resampled_a, resampled_b, score_a, score_b);
+    }
+    else if (mobile_size < ref_size)
+    {
+        upsample(mobile, ref_size, resampled_a);
+        aligned_rms(resampled_a, ref_a, ref_b, score_a, score_b);
+    }
+    else
+    {
+        aligned_rms(mobile, ref_a, ref_b, score_a, score_b);
+    }
+}
+
+/* CenteredRef */
+CenteredRef::CenteredRef(V3fList const& points) {
+    size_t const n = points.size();
+    double yc[3] = { 0 };
+    for (auto const& point : points) {
+        yc[0] += point[0];
+        yc[1] += point[1];
+        yc[2] += point[2];
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        yc[i] = yc[i] / n;
+    }
+
+    xs.reserve(n);
+    ys.reserve(n);
+    zs.reserve(n);
+    for (auto const& point : points) {
+        xs.push_back(point[0] - yc[0]);
+        ys.push_back(point[1] - yc[1]);
+        zs.push_back(point[2] - yc[2]);
+        sq_sum += xs.back() * xs.back() +
+                  ys.back() * ys.back() +
+                  zs.back() * zs.back();
+    }
+}
+
+/* CenteredPath */
+CenteredPath::CenteredPath(V3fList const& path,
+                           std::vector<V3fList> const& upsampled) :
+    path_(&path)
+{
+    refs_.reserve(1 + upsampled.size());
+    refs_.emplace_back(path);
+    for (auto const& points : upsampled) {
+        DEBUG_NOMSG(points.size() != path.size() + refs_.size());
+        refs_.emplace_back(points);
+    }
+}
+
+CenteredRef const* CenteredPath::find(size_t const size) const {
+    size_t const first_size = path_->size();
+    return size >= first_size and size - first_size < refs_.size() ?
+           &refs_[size - first_size] : nullptr;
+}
+
+/* PointBatch */
+PointBatch::PointBatch(std::vector<V3fList const*> const& refs) :
+    refs_(refs),
+    centered_refs_(refs.size())
+{
+    DEBUG_NOMSG(refs_.size() > 8 * sizeof(RefMask));
+}
+
+PointBatch::PointBatch(std::vector<CenteredPath const*> const& centered_paths) :
+    centered_paths_(centered_paths),
+    centered_refs_(centered_paths.size())
 {
-    size_t index;
-    float distance;
-    size_t edges;
-    Vector3f const * a;
-    Vector3f const * b;
-    SampleSegment(size_t const index_, Vector3f const& a_, Vector3f const& b_) : 
-        index(index_), distance(a_.sq_dist_to(b_)), edges(1), a(&a_), b(&b_) {}
-    bool operator<(SampleSegment const& other) const {
-        return (distance / edges) < (other.distance / other.edges);
-    }
-    static bool index_compare(SampleSegment const& a, SampleSegment const& b) {
-        // Should a go before b?
-        return a.index < b.index;
-    }
-};
-
-V3fList _upsample(V3fList const& points, size_t const target) {
+    DEBUG_NOMSG(centered_paths_.size() > 8 * sizeof(RefMask));
+    for (auto const centered_path : centered_paths_) {
+        refs_.push_back(&centered_path->path());
+    }
+}
+
+CenteredRef const& PointBatch::centered_ref(size_t const ref_id,
+                                            size_t const size) const {
+    if (not centered_paths_.empty()) {
+        if (auto const shared = centered_paths_[ref_id]->find(size)) {
+            return *shared;
+        }
+    }
+    return centered_refs_[ref_id].at(size);
+}
+
+size_t PointBatch::ref_id(V3fList const* const ref) const {
+    auto const itr = std::find(begin(refs_), end(refs_), ref);
+    DEBUG_NOMSG(itr == end(refs_));
+    return itr - begin(refs_);
+}
+
+void PointBatch::resize(std::vector<size_t> const& sizes) {
+    size_t const n = sizes.size();
+
+    offsets_.resize(n + 1);
+    offsets_[0] = 0;
+    std::partial_sum(begin(sizes), end(sizes), begin(offsets_) + 1);
+
+    size_t const n_points = offsets_.back();
+    xs_.resize(n_points);
+    ys_.resize(n_points);
+    zs_.resize(n_points);
+
+    ref_masks_.assign(n, 0);
+    scores_.assign(n * refs_.size(), INFINITY);
+}
+
+void PointBatch::add_centered_ref(size_t const ref_id, size_t const size) {
+    if (not centered_paths_.empty() and centered_paths_[ref_id]->find(size)) {
+        return;
+    }
+
+    auto& centered_refs = centered_refs_[ref_id];
+    if (centered_refs.find(size) == end(centered_refs)) {
+        V3fList const& ref = *refs_[ref_id];
+        centered_refs.emplace(size,
+                              size == ref.size() ? ref : upsample(ref, size));
+    }
+}
+
+void score_aligned_batch(PointBatch& batch) {
+    auto const& refs = batch.refs();
+    size_t const n_refs = refs.size();
+    size_t const n_sets = batch.n_sets();
+    float const cutoff = batch.cutoff();
+
+    // Find the sizes each reference needs to be resampled to. Like _score(),
+    // the shorter of the two lists gets upsampled.
+    for (size_t set = 0; set < n_sets; ++set) {
+        size_t const n = batch.size_of(set);
+        for (size_t ref_id = 0; ref_id < n_refs; ++ref_id) {
+            if (batch.ref_mask(set) & (1 << ref_id)) {
+                size_t const ref_n = refs[ref_id]->size();
+                if (n > 1 and ref_n > 1) {
+                    batch.add_centered_ref(ref_id, std::max(n, ref_n));
+                }
+            }
+        }
+    }
+
+    OMP_PAR_FOR
+    for (size_t set = 0; set < n_sets; ++set) {
+        PointBatch::RefMask const mask = batch.ref_mask(set);
+        size_t const n = batch.size_of(set);
+        size_t const offset = batch.offset(set);
+
+        // Settle trivial sizes first, like _score().
+        size_t pending[8 * sizeof(PointBatch::RefMask)];
+        size_t n_pending = 0;
+        for (size_t ref_id = 0; ref_id < n_refs; ++ref_id) {
+            if (not (mask & (1 << ref_id))) continue;
+
+            size_t const ref_n = refs[ref_id]->size();
+            if (n == 1 and ref_n == 1) {
+                batch.set_score(set, ref_id, 0);
+            }
+            else if (n <= 1 or ref_n <= 1) {
+                batch.set_score(set, ref_id, INFINITY);
+            }
+            else {
+                pending[n_pending++] = ref_id;
+            }
+        }
+
+        // References that resample to the same size share a single pass
+        // over the candidate points, e.g. a path and its reverse.
+        for (size_t p = 0; p < n_pending;) {
+            size_t const ref_id = pending[p];
+            size_t const size = std::max(n, refs[ref_id]->size());
+
+            float const* xs = batch.xs() + offset;
+            float const* ys = batch.ys() + offset;
+            float const* zs = batch.zs() + offset;
+            if (size > n) {
+                // Rare: candidate is shorter than the reference.
+                thread_local V3fList points, resampled;
+                points.clear();
+                for (size_t i = offset; i < offset + n; ++i) {
+                    points.emplace_back(batch.xs()[i],
+                                        batch.ys()[i],
+                                        batch.zs()[i]);
+                }
+                upsample(points, size, resampled);
+
+                thread_local std::vector<float> rxs, rys, rzs;
+                rxs.clear();
+                rys.clear();
+                rzs.clear();
+                for (auto const& point : resampled) {
+                    rxs.push_back(point[0]);
+                    rys.push_back(point[1]);
+                    rzs.push_back(point[2]);
+                }
+
+                xs = rxs.data();
+                ys = rys.data();
+                zs = rzs.data();
+            }
+
+            // Reject against the cutoff before the exact solve. The margin
+            // keeps float rounding of the exact score from flipping a
+            // candidate that sits right at the cutoff.
+            double const sq_sum = std::isinf(cutoff) ?
+                                  0 : centered_sq_sum(xs, ys, zs, size);
+            auto const rejects = [&](size_t const id, float& bound) {
+                if (std::isinf(cutoff)) return false;
+                bound = residual_lower_bound(
+                            sq_sum, batch.centered_ref(id, size).sq_sum);
+                return bound * (1 - 1e-4) > cutoff;
+            };
+
+            size_t const n_same = (p + 1 < n_pending and
+                                   std::max(n, refs[pending[p + 1]]->size()) ==
+                                   size) ? 2 : 1;
+
+            // Exact scores still needed, out of the n_same references.
+            size_t exact[2];
+            size_t n_exact = 0;
+            for (size_t i = 0; i < n_same; ++i) {
+                float bound;
+                if (rejects(pending[p + i], bound)) {
+                    batch.set_score(set, pending[p + i], bound);
+                }
+                else {
+                    exact[n_exact++] = pending[p + i];
+                }
+            }
+
+            if (n_exact == 2) {
+                auto const& ref_a = batch.centered_ref(exact[0], size);
+                auto const& ref_b = batch.centered_ref(exact[1], size);
+
+                float score_a, score_b;
+                aligned_rms(xs, ys, zs, ref_a, ref_b, score_a, score_b);
+                batch.set_score(set, exact[0], score_a);
+                batch.set_score(set, exact[1], score_b);
+            }
+            else if (n_exact == 1) {
+                auto const& ref_a = batch.centered_ref(exact[0], size);
+                batch.set_score(set, exact[0], aligned_rms(xs, ys, zs, ref_a));
+            }
+
+            p += n_same;
+        }
+    }
+}
+
+void upsample(V3fList const& points, size_t const target, V3fList& result) {
     // Upsamples points to <target> number of point.
     DEBUG_NOMSG(points.size() > target);
     DEBUG_NOMSG(points.size() < 1);
+    DEBUG_NOMSG(&points == &result);
+
+    result.clear();
 
     // Special case: single point upsampling = duplicating it <target> times.
     if (points.size() == 1) {
-        V3fList result;
-        for (size_t i = 0; i < target; ++i)
-            result.push_back(points.at(0));
-        return result;
+        result.assign(target, points.at(0));
+        return;
     }
 
-    // Construct segment max heap for selection.
-    std::vector<SampleSegment> segments;
-    for (size_t i = 1; i < points.size(); ++i)
-        segments.emplace_back(i, points.at(i - 1), points.at(i));
-    std::make_heap(segments.begin(), segments.end());
+    // Each inserted point splits the segment with the longest squared length
+    // per edge. Instead of popping a heap once per point, first hand out the
+    // splits whose priority is at least total / remaining: greedy would take
+    // all of those anyway. The few left over are then handed out greedily,
+    // lower index first on ties.
+    size_t const n_segments = points.size() - 1;
+    thread_local std::vector<float> sq_lens;
+    thread_local std::vector<size_t> edges;
+    sq_lens.resize(n_segments);
+    edges.assign(n_segments, 1);
+
+    double total = 0.0;
+    for (size_t i = 0; i < n_segments; ++i) {
+        sq_lens[i] = points[i].sq_dist_to(points[i + 1]);
+        total += sq_lens[i];
+    }
 
-    // Insert a point in the centre of the longest segment until target is met.
     size_t remaining = target - points.size();
-    while (remaining--) {
-        // Remove longest segment from heap temporarily
-        std::pop_heap(segments.begin(), segments.end());
-
-        // Split segment
-        segments.back().edges++;
+    if (remaining > 0 and total > 0) {
+        double const min_priority = total / remaining;
+        for (size_t i = 0; i < n_segments; ++i) {
+            size_t const splits = std::min(
+                                      remaining,
+                                      static_cast<size_t>(sq_lens[i] / min_priority));
+            edges[i] += splits;
+            remaining -= splits;
+        }
+    }
 
-        // Put split segment back to heap
-        std::push_heap(segments.begin(), segments.end());
+    while (remaining--) {
+        size_t longest = 0;
+        for (size_t i = 1; i < n_segments; ++i) {
+            if (sq_lens[i] / edges[i] > sq_lens[longest] / edges[longest]) {
+                longest = i;
+            }
+        }
+        edges[longest]++;
     }
 
-    // Pack result into vector
-    std::sort_heap(segments.begin(), segments.end(), SampleSegment::index_compare);
-    V3fList result = {points.at(0)};
-    for (auto const& segment : segments) {
-        // Insert <edges - 1> new points and point b
-        Vector3f direction = (*segment.b) - (*segment.a);
-        for (size_t i = 1; i < segment.edges; ++i) {
-            result.push_back((*segment.a) + direction * (static_cast<float>(i) / segment.edges));
+    // Pack result: insert <edges - 1> new points and point b per segment.
+    result.push_back(points.at(0));
+    for (size_t i = 0; i < n_segments; ++i) {
+        Vector3f const& a = points[i];
+        Vector3f const& b = points[i + 1];
+        Vector3f const direction = b - a;
+        for (size_t j = 1; j < edges[i]; ++j) {
+            result.push_back(a + direction * (static_cast<float>(j) / edges[i]));
         }
-        result.push_back(*segment.b);
+        result.push_back(b);
     }
+}
+
+V3fList upsample(V3fList const& points, size_t const target) {
+    V3fList result;
+    upsample(points, target, result);
     return result;
 }
 
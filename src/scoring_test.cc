@@ -1,5 +1,7 @@
 #include "scoring.h"
 
+#include <algorithm>
+
 #include "test_stat.h"
 #include "test_data.h"
 #include "input_manager.h"
@@ -108,7 +110,7 @@ TestStat test_upsample() {
                       begin(a_fewer) + (a_fewer.size() / 2) + 1);
         assert(a_fewer.size() != points10a.size());
 
-        a_fewer = _upsample(a_fewer, points10a.size());
+        a_fewer = upsample(a_fewer, points10a.size());
 
         ts.tests++;
         if (a_fewer.size() != points10a.size()) {
@@ -118,6 +120,32 @@ TestStat test_upsample() {
         }
     }
 
+    // Test that new points go to the longest segments, evenly spaced.
+    {
+        ts.tests++;
+
+        V3fList const points = {{0, 0, 0}, {1, 0, 0}, {4, 0, 0}};
+        V3fList const expected =
+            {{0, 0, 0}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}, {4, 0, 0}};
+        V3fList const upsampled = upsample(points, expected.size());
+        if (upsampled != expected) {
+            ts.errors++;
+            JUtil.error("Upsampling failed to split the longest segment.\n");
+        }
+    }
+
+    // Test that upsampling into a reused list gives the same points.
+    {
+        ts.tests++;
+
+        V3fList reused = points10b;
+        upsample(points10a, 23, reused);
+        if (reused != upsample(points10a, 23)) {
+            ts.errors++;
+            JUtil.error("Upsampling into a reused list gave different points.\n");
+        }
+    }
+
     return ts;
 }
 
@@ -327,12 +355,248 @@ TestStat test_score() {
     return ts;
 }
 
+TestStat test_score_batch() {
+    TestStat ts;
+
+    V3fList const points10b_rev(rbegin(points10b), rend(points10b));
+    V3fList const points7a(begin(points10a), begin(points10a) + 7);
+    V3fList const points13a = upsample(points10a, 13);
+    V3fList const points1a = {points10a.at(0)};
+
+    // Sets are shorter, equal to and longer than the references.
+    std::vector<V3fList const*> sets =
+        {&points10a, &points7a, &points13a, &points1a, &points10b};
+    std::vector<V3fList const*> const refs = {&points10b, &points10b_rev};
+
+    // Shared references stop short of the longest set, which the batch then
+    // centers itself.
+    CenteredPath const fwd_path(points10b,
+                                {upsample(points10b, 11),
+                                 upsample(points10b, 12)});
+    CenteredPath const bwd_path(points10b_rev,
+                                {upsample(points10b_rev, 11),
+                                 upsample(points10b_rev, 12)});
+    PointBatch own_batch(refs);
+    PointBatch shared_batch(
+        std::vector<CenteredPath const*>{&fwd_path, &bwd_path});
+
+    // Every other pass lays the sets out in reverse, reusing the references
+    // centered in the pass before.
+    for (size_t pass = 0; pass < 4; ++pass) {
+        PointBatch& batch = pass < 2 ? own_batch : shared_batch;
+        std::vector<size_t> sizes;
+        for (auto const set : sets) {
+            sizes.push_back(set->size());
+        }
+        batch.resize(sizes);
+
+        for (size_t set = 0; set < sets.size(); ++set) {
+            for (size_t i = 0; i < sets[set]->size(); ++i) {
+                batch.set_point(set, i, sets[set]->at(i));
+            }
+            // Leave out the backward reference for one set.
+            batch.set_ref_mask(set, set == 2 ? 0b01 : 0b11);
+        }
+
+        score_aligned_batch(batch);
+
+        for (size_t set = 0; set < sets.size(); ++set) {
+            for (size_t ref_id = 0; ref_id < refs.size(); ++ref_id) {
+                ts.tests++;
+
+                bool const requested = batch.ref_mask(set) & (1 << ref_id);
+                float const expected = requested ?
+                                       score_aligned(*sets[set],
+                                                     *refs[ref_id]) :
+                                       INFINITY;
+                float const got = batch.score(set, ref_id);
+
+                // Summation order differs, so allow for float rounding.
+                bool const ok = std::isinf(expected) ?
+                                std::isinf(got) :
+                                abs(got - expected) <=
+                                std::max(EPSILON, 1e-5 * abs(expected));
+                if (not ok) {
+                    ts.errors++;
+                    JUtil.error("Batch aligned score test failed for set "
+                                "%zu against ref %zu in pass %zu.\n"
+                                "Expected %f\nGot %f\n",
+                                set, ref_id, pass, expected, got);
+                }
+            }
+        }
+
+        std::reverse(begin(sets), end(sets));
+    }
+
+    return ts;
+}
+
+TestStat test_score_pair() {
+    TestStat ts;
+
+    V3fList const points10b_rev(rbegin(points10b), rend(points10b));
+    V3fList const points7a(begin(points10a), begin(points10a) + 7);
+    V3fList const points13a = upsample(points10a, 13);
+
+    for (auto const mobile : {&points10a, &points7a, &points13a}) {
+        ts.tests++;
+
+        float fwd_score, bwd_score;
+        score_aligned_pair(*mobile, points10b, points10b_rev,
+                           fwd_score, bwd_score);
+
+        float const expected_fwd = score_aligned(*mobile, points10b);
+        float const expected_bwd = score_aligned(*mobile, points10b_rev);
+        if (abs(fwd_score - expected_fwd) >
+                std::max(EPSILON, 1e-5 * abs(expected_fwd)) or
+                abs(bwd_score - expected_bwd) >
+                std::max(EPSILON, 1e-5 * abs(expected_bwd))) {
+            ts.errors++;
+            JUtil.error("Paired aligned score test failed for %zu points.\n"
+                        "Expected %f, %f\nGot %f, %f\n",
+                        mobile->size(),
+                        expected_fwd, expected_bwd,
+                        fwd_score, bwd_score);
+        }
+    }
+
+    return ts;
+}
+
+TestStat test_score_cutoff() {
+    TestStat ts;
+
+    V3fList const points10b_rev(rbegin(points10b), rend(points10b));
+
+    // Spread points10a out so that the spread bound alone rejects it.
+    V3fList points10a_wide;
+    for (auto const& point : points10a) {
+        points10a_wide.push_back(point * 4);
+    }
+
+    std::vector<V3fList const*> const sets =
+        {&points10a, &points10b, &points10a_wide};
+    std::vector<V3fList const*> const refs = {&points10b, &points10b_rev};
+
+    float const cutoff = score_aligned(points10a, points10b);
+
+    PointBatch batch(refs);
+    std::vector<size_t> sizes;
+    for (auto const set : sets) {
+        sizes.push_back(set->size());
+    }
+    batch.resize(sizes);
+    batch.set_cutoff(cutoff);
+
+    for (size_t set = 0; set < sets.size(); ++set) {
+        for (size_t i = 0; i < sets[set]->size(); ++i) {
+            batch.set_point(set, i, sets[set]->at(i));
+        }
+        batch.set_ref_mask(set, 0b11);
+    }
+
+    score_aligned_batch(batch);
+
+    for (size_t set = 0; set < sets.size(); ++set) {
+        for (size_t ref_id = 0; ref_id < refs.size(); ++ref_id) {
+            ts.tests++;
+
+            // Scores within the cutoff must be exact. Others may be any lower
+            // bound that stays above the cutoff.
+            float const expected = score_aligned(*sets[set], *refs[ref_id]);
+            float const got = batch.score(set, ref_id);
+            float const tolerance = std::max(EPSILON, 1e-5 * abs(expected));
+            bool const ok = expected <= cutoff ?
+                            abs(got - expected) <= tolerance :
+                            got > cutoff and got <= expected + tolerance;
+            if (not ok) {
+                ts.errors++;
+                JUtil.error("Batch cutoff test failed for set %zu "
+                            "against ref %zu.\nCutoff %f\nExact %f\nGot %f\n",
+                            set, ref_id, cutoff, expected, got);
+            }
+        }
+    }
+
+    // The spread-out set must have been rejected by its bound.
+    ts.tests++;
+    if (batch.score(2, 0) >= score_aligned(points10a_wide, points10b)) {
+        ts.errors++;
+        JUtil.error("Batch cutoff test failed: wide set was not rejected.\n");
+    }
+
+    return ts;
+}
+
+TestStat test_qcp() {
+    TestStat ts;
+
+    V3fList const points10b_rev(rbegin(points10b), rend(points10b));
+    std::vector<std::pair<V3fList const*, V3fList const*>> const cases = {
+        {&points10a, &points10a},
+        {&points10a, &points10b},
+        {&points10a, &points10b_rev},
+        {&points10b, &points10a}
+    };
+
+    std::vector<float> rosetta_scores;
+    InputManager::setup_test({"--rmsd_engine", "rosetta"});
+    for (auto const& [mobile, ref] : cases) {
+        rosetta_scores.push_back(score_aligned(*mobile, *ref));
+    }
+
+    InputManager::setup_test({"--rmsd_engine", "qcp"});
+    for (size_t i = 0; i < cases.size(); ++i) {
+        ts.tests++;
+
+        auto const& [mobile, ref] = cases[i];
+        float const expected = rosetta_scores[i];
+        float const got = score_aligned(*mobile, *ref);
+        if (abs(got - expected) > std::max(EPSILON, EPSILON * abs(expected))) {
+            ts.errors++;
+            JUtil.error("QCP score test failed for case %zu.\n"
+                        "Expected %f\nGot %f\n", i, expected, got);
+        }
+    }
+
+    // Test QCP rotation against the Rosetta one.
+    {
+        ts.tests++;
+
+        elfin::Mat3f rot;
+        Vector3f tran;
+        calc_alignment(points10a, points10b, rot, tran);
+
+        bool ok = tran.is_approx(points10ab_tran);
+        for (size_t i = 0; i < 3; i++) {
+            ok &= Vector3f(rot[i]).is_approx(points10ab_rot[i]);
+        }
+
+        if (not ok) {
+            ts.errors++;
+            JUtil.error("QCP alignment test failed.\n"
+                        "Translation expected: %s\nGot: %s\n",
+                        points10ab_tran.to_string().c_str(),
+                        tran.to_string().c_str());
+        }
+    }
+
+    InputManager::setup_test({});
+
+    return ts;
+}
+
 TestStat test() {
     TestStat ts;
 
     ts += test_basics();
     ts += test_upsample();
     ts += test_score();
+    ts += test_score_pair();
+    ts += test_score_batch();
+    ts += test_score_cutoff();
+    ts += test_qcp();
 
     return ts;
 }
@@ -0,0 +1,185 @@
+#include "seeding.h"
+
+#include <algorithm>
+
+#include "json.h"
+#include "exceptions.h"
+#include "input_manager.h"
+#include "work_area.h"
+
+namespace elfin {
+
+namespace seeding {
+
+// Throws if the step cannot link to next.
+static void check_link(tests::RecipeStep const& step,
+                       tests::RecipeStep const& next) {
+    auto const src_mod = XDB.get_mod(step.mod_name);
+    auto const dst_mod = XDB.get_mod(next.mod_name);
+
+    PANIC_IF(step.src_term != TermType::N and step.src_term != TermType::C,
+             BadTerminus("No terminus after " + step.mod_name));
+
+    auto const pt_link = src_mod->find_link_to(
+                             src_mod->get_chain_id(step.src_chain),
+                             step.src_term,
+                             dst_mod,
+                             dst_mod->get_chain_id(step.dst_chain));
+
+    PANIC_IF(not pt_link,
+             ValueNotFound("No link from " + step.mod_name +
+                           " to " + next.mod_name));
+}
+
+// Recipe step linking the hinge of joint hinge_name to first, if any.
+static bool find_hinge_step(std::string const& hinge_name,
+                            UIJointKey const hinge_joint,
+                            tests::RecipeStep const& first,
+                            tests::Recipe& res) {
+    auto const hinge_mod =
+        XDB.get_mod(hinge_joint->occupant.ui_module->module_name);
+    auto const first_mod = XDB.get_mod(first.mod_name);
+
+    // Try the terminus and chain the rest of the path continues on first.
+    TermType const first_term =
+        first.src_term == TermType::C ? TermType::C : TermType::N;
+    for (TermType const term : {first_term, opposite_term(first_term)}) {
+        for (auto const& src_chain : hinge_mod->chains()) {
+            std::vector<ProtoChain const*> dst_chains;
+            for (auto const& dst_chain : first_mod->chains()) {
+                dst_chains.push_back(&dst_chain);
+            }
+            std::stable_partition(begin(dst_chains), end(dst_chains),
+            [&](ProtoChain const* const chain) {
+                return chain->name == first.src_chain;
+            });
+
+            for (auto const dst_chain : dst_chains) {
+                if (hinge_mod->find_link_to(
+                            src_chain.id, term, first_mod, dst_chain->id)) {
+                    res.push_back({hinge_mod->name,
+                                   term,
+                                   src_chain.name,
+                                   dst_chain->name,
+                                   hinge_name});
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+// Builds the seed of one solution, throwing if it does not fit work_area.
+static Seed parse_solution(JSON const& solution_json,
+                           WorkArea const& work_area) {
+    JSON const& nodes_json = solution_json.is_object() ?
+                             solution_json.at("nodes") :
+                             solution_json;
+
+    PANIC_IF(nodes_json.empty(), ValueNotFound("Solution has no nodes"));
+
+    tests::Recipe steps;
+    for (auto const& node_json : nodes_json) {
+        // The last node of a path links to nothing.
+        std::string const term_str = node_json.at("src_term");
+        TermType const src_term = term_str == TermTypeToCStr(TermType::NONE) ?
+                                  TermType::NONE :
+                                  parse_term(term_str);
+
+        std::string ui_name = "?";
+        auto const ui_name_itr = node_json.find("ui_name");
+        if (ui_name_itr != node_json.end()) {
+            ui_name = ui_name_itr->get<std::string>();
+        }
+
+        steps.push_back({node_json.at("name").get<std::string>(),
+                         src_term,
+                         node_json.at("src_chain_name").get<std::string>(),
+                         node_json.at("dst_chain_name").get<std::string>(),
+                         ui_name});
+    }
+
+    Seed seed;
+    if (work_area.type == WorkType::FREE) {
+        // Place the team where it was written out.
+        seed.shift_tx = Transform(nodes_json.at(0));
+    }
+    else {
+        auto const& omap = work_area.occupied_joints;
+        auto hinge_itr = omap.find(steps.at(0).ui_name);
+        if (hinge_itr == end(omap)) {
+            for (hinge_itr = begin(omap); hinge_itr != end(omap); ++hinge_itr) {
+                if (find_hinge_step(hinge_itr->first,
+                                    hinge_itr->second,
+                                    steps.at(0),
+                                    seed.recipe)) {
+                    break;
+                }
+            }
+
+            PANIC_IF(hinge_itr == end(omap),
+                     ValueNotFound("No hinge links to " + steps.at(0).mod_name));
+        }
+        seed.shift_tx = hinge_itr->second->occupant.ui_module->tx;
+    }
+
+    for (auto const& step : steps) {
+        seed.recipe.push_back(step);
+    }
+
+    // A single node has no link to rebuild a team around.
+    PANIC_IF(seed.recipe.size() < 2,
+             ValueNotFound("Solution has fewer than two nodes"));
+    for (size_t i = 0; i + 1 < seed.recipe.size(); ++i) {
+        check_link(seed.recipe[i], seed.recipe[i + 1]);
+    }
+
+    return seed;
+}
+
+/* free functions */
+Seeds load(std::string const& file, WorkArea const& work_area) {
+    Seeds res;
+
+    JSON const json = parse_json(file);
+
+    // Solver outputs group work areas under their work packages.
+    JSON solutions_json;
+    auto const pg_networks_itr = json.find("pg_networks");
+    if (pg_networks_itr != json.end()) {
+        for (auto const& [wp_name, wp_json] : pg_networks_itr->items()) {
+            auto const wa_itr = wp_json.find(work_area.name);
+            if (wa_itr != wp_json.end()) {
+                solutions_json = *wa_itr;
+            }
+        }
+    }
+    else {
+        auto const wa_itr = json.find(work_area.name);
+        if (wa_itr != json.end()) {
+            solutions_json = *wa_itr;
+        }
+    }
+
+    for (auto const& solution_json : solutions_json) {
+        try {
+            res.push_back(parse_solution(solution_json, work_area));
+        }
+        catch (JSON::exception const& je) {
+            JUtil.warn("Skipping seed solution of %s: %s\n",
+                       work_area.name.c_str(), je.what());
+        }
+        catch (ElfinException const& ee) {
+            JUtil.warn("Skipping seed solution of %s: %s\n",
+                       work_area.name.c_str(), ee.what());
+        }
+    }
+
+    return res;
+}
+
+}  /* seeding */
+
+}  /* elfin */
@@ -0,0 +1,104 @@
+#include "seeding.h"
+
+#include "test_data.h"
+#include "test_stat.h"
+#include "input_manager.h"
+#include "hinge_team.h"
+#include "scoring.h"
+
+namespace elfin {
+
+namespace seeding {
+
+/* tests */
+TestStat test() {
+    TestStat ts;
+
+    // Writes solutions of wa as the solver outputs them, and loads them back.
+    auto const write_and_load =
+    [&](WorkArea const& wa, JSON const& solutions_json) {
+        JSON output_json;
+        output_json["pg_networks"]["test_wp"][wa.name] = solutions_json;
+
+        JUtil.mkdir_ifn_exists(OPTIONS.output_dir.c_str());
+        std::string const path = OPTIONS.output_dir + "/seeding_test.json";
+        std::string const dump = output_json.dump();
+        JUtil.write_binary(path.c_str(), dump.c_str(), dump.size());
+
+        return load(path, wa);
+    };
+
+    auto const check_rebuilt =
+    [&](std::string const& spec_file, PathTeam& team, Seeds const& seeds) {
+        ts.tests++;
+        if (seeds.size() != 1) {
+            ts.errors++;
+            JUtil.error("Seeding test of %s loaded %zu solutions "
+                        "instead of 1\n", spec_file.c_str(), seeds.size());
+            return;
+        }
+
+        team.implement_recipe(seeds.at(0).recipe, seeds.at(0).shift_tx);
+
+        ts.tests++;
+        if (team.score() > scoring::SCORE_FLOOR) {
+            ts.errors++;
+            JUtil.error("Seeding test of %s rebuilt a team scoring %f "
+                        "instead of 0\n", spec_file.c_str(), team.score());
+        }
+    };
+
+    // A free team comes back where it was written out.
+    {
+        std::string const spec_file = "examples/quarter_snake_free.json";
+        InputManager::setup_test({"--spec_file", spec_file});
+        Spec const spec(OPTIONS);
+        auto const& wa = *(*begin(spec.work_packages()))->work_area_keys().at(0);
+
+        PathTeam team(&wa, OPTIONS.seed);
+        team.implement_recipe(tests::QUARTER_SNAKE_FREE_RECIPE);
+
+        // Solutions that do not fit are skipped, as are single nodes.
+        JSON bad_json = team.to_json();
+        bad_json.at(1)["name"] = "not_a_module";
+
+        JSON single_json;
+        single_json.push_back(team.to_json().at(0));
+
+        JSON solutions_json;
+        solutions_json.push_back(team.to_json());
+        solutions_json.push_back(bad_json);
+        solutions_json.push_back(single_json);
+
+        PathTeam rebuilt(&wa, OPTIONS.seed);
+        check_rebuilt(spec_file, rebuilt, write_and_load(wa, solutions_json));
+    }
+
+    // A hinged team is written out without its hinge, which is put back.
+    {
+        std::string const spec_file = "examples/H_1h.json";
+        InputManager::setup_test({"--spec_file", spec_file});
+        Spec const spec(OPTIONS);
+        auto const& wa = *(*begin(spec.work_packages()))->work_area_keys().at(0);
+
+        HingeTeam team(&wa, OPTIONS.seed);
+        auto const& [hinge_name, hinge_joint] = *begin(wa.occupied_joints);
+        team.implement_recipe(tests::H_1H_RECIPE,
+                              hinge_joint->occupant.ui_module->tx);
+
+        JSON solution_json;
+        solution_json["nodes"] = team.to_json();
+
+        JSON solutions_json;
+        solutions_json.push_back(solution_json);
+
+        HingeTeam rebuilt(&wa, OPTIONS.seed);
+        check_rebuilt(spec_file, rebuilt, write_and_load(wa, solutions_json));
+    }
+
+    return ts;
+}
+
+}  /* seeding */
+
+}  /* elfin */
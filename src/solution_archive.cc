@@ -0,0 +1,109 @@
+#include "solution_archive.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "parallel_utils.h"
+
+namespace elfin {
+
+/* ctors */
+SolutionArchive::SolutionArchive(TeamSPMaxHeap& heap,
+                                 size_t const capacity) :
+    heap_(heap),
+    capacity_(capacity)
+{
+    for (auto const& team : heap_.container()) {
+        checksums_.insert(team->checksum());
+    }
+
+    while (heap_.size() > capacity_) {
+        checksums_.erase(heap_.top_and_pop()->checksum());
+    }
+}
+
+/* accessors */
+float SolutionArchive::worst_score() const {
+    if (heap_.size() < capacity_) {
+        return INFINITY;
+    }
+    return heap_.empty() ? -INFINITY : heap_.top()->score();
+}
+
+SolutionArchive::Candidates SolutionArchive::candidates(
+    std::vector<NodeTeamSP> const& teams) const
+{
+    // Copies of a team score the same, so they would sit next to it and
+    // take slots that merge() then leaves empty.
+    Candidates res;
+    std::unordered_set<Crc32> seen;
+    for (auto const& team : teams) {
+        if (accepts(*team) and seen.insert(team->checksum()).second) {
+            res.push_back(team.get());
+        }
+    }
+
+    // No more than capacity of them can make it in.
+    auto const better = [](NodeTeam const* const lhs,
+                           NodeTeam const* const rhs) {
+        return lhs->score() < rhs->score();
+    };
+    if (res.size() > capacity_) {
+        std::partial_sort(begin(res), begin(res) + capacity_, end(res), better);
+        res.resize(capacity_);
+    }
+    else {
+        std::sort(begin(res), end(res), better);
+    }
+
+    return res;
+}
+
+/* modifiers */
+bool SolutionArchive::insert(NodeTeam const& team) {
+    if (not accepts(team)) {
+        return false;
+    }
+
+    if (heap_.size() >= capacity_) {
+        checksums_.erase(heap_.top_and_pop()->checksum());
+    }
+
+    checksums_.insert(team.checksum());
+    heap_.push(team.clone());
+    return true;
+}
+
+void SolutionArchive::merge(std::vector<Candidates> const& candidate_lists) {
+    size_t const n_lists = candidate_lists.size();
+
+    // Candidates the archive would not take as it is now never make it in
+    // later, as its worst score only drops.
+    std::vector<Candidates> filtered(n_lists);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < n_lists; ++i) {
+        for (auto const team : candidate_lists[i]) {
+            if (accepts(*team)) {
+                filtered[i].push_back(team);
+            }
+        }
+    }
+
+    Candidates merged;
+    for (auto const& list : filtered) {
+        merged.insert(end(merged), begin(list), end(list));
+    }
+    std::stable_sort(begin(merged), end(merged),
+    [](NodeTeam const* const lhs, NodeTeam const* const rhs) {
+        return lhs->score() < rhs->score();
+    });
+
+    for (auto const team : merged) {
+        if (not (team->score() < worst_score())) {
+            break;
+        }
+        insert(*team);
+    }
+}
+
+}  /* elfin */
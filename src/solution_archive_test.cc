@@ -0,0 +1,139 @@
+#include "solution_archive.h"
+
+#include <algorithm>
+
+#include "test_stat.h"
+#include "input_manager.h"
+#include "node_team.h"
+
+namespace elfin {
+
+/* tests */
+TestStat SolutionArchive::test() {
+    TestStat ts;
+
+    InputManager::setup_test({"--spec_file", "examples/quarter_snake_free.json"});
+    Spec const spec(OPTIONS);
+    auto const wa = (*begin(spec.work_packages()))->work_area_keys().at(0);
+
+    std::vector<NodeTeamSP> teams;
+    for (uint64_t i = 0; i < 16; ++i) {
+        teams.push_back(NodeTeam::create_team(wa, random::Stream(i)));
+        teams.back()->randomize();
+    }
+
+    // Reference: the best distinct teams.
+    size_t const capacity = 5;
+    std::vector<NodeTeam const*> best;
+    {
+        std::vector<NodeTeam const*> sorted;
+        for (auto const& team : teams) {
+            sorted.push_back(team.get());
+        }
+        std::stable_sort(begin(sorted), end(sorted),
+        [](NodeTeam const* const lhs, NodeTeam const* const rhs) {
+            return lhs->score() < rhs->score();
+        });
+
+        for (auto const team : sorted) {
+            bool const repeat = std::any_of(begin(best), end(best),
+            [&](NodeTeam const* const other) {
+                return other->checksum() == team->checksum();
+            });
+            if (not repeat and best.size() < capacity) {
+                best.push_back(team);
+            }
+        }
+    }
+
+    auto const check_best =
+    [&](TeamSPMaxHeap const& heap, char const* const how) {
+        std::vector<float> scores;
+        for (auto const& team : heap.container()) {
+            scores.push_back(team->score());
+        }
+        std::sort(begin(scores), end(scores));
+
+        std::vector<float> best_scores;
+        for (auto const team : best) {
+            best_scores.push_back(team->score());
+        }
+
+        ts.tests++;
+        if (scores != best_scores) {
+            ts.errors++;
+            JUtil.error("SolutionArchive %s kept %zu teams that are not "
+                        "the best %zu\n", how, scores.size(), best.size());
+        }
+    };
+
+    // Teams inserted one by one, each twice, leave the best distinct ones.
+    {
+        TeamSPMaxHeap heap;
+        SolutionArchive archive(heap, capacity);
+        for (auto const& team : teams) {
+            archive.insert(*team);
+            archive.insert(*team);
+        }
+        check_best(heap, "insert()");
+
+        ts.tests++;
+        if (archive.insert(*heap.top())) {
+            ts.errors++;
+            JUtil.error("SolutionArchive took a team it already had\n");
+        }
+    }
+
+    // Overlapping candidate lists merge into the same.
+    {
+        TeamSPMaxHeap heap;
+        SolutionArchive archive(heap, capacity);
+        std::vector<NodeTeamSP> half1, half2;
+        for (size_t i = 0; i < teams.size(); ++i) {
+            if (i < 10) half1.push_back(teams[i]->clone());
+            if (i >= 6) half2.push_back(teams[i]->clone());
+        }
+        archive.merge({archive.candidates(half1), archive.candidates(half2)});
+        check_best(heap, "merge()");
+
+        // An archive over a heap indexes what is already in it.
+        SolutionArchive reopened(heap, capacity);
+        ts.tests++;
+        if (reopened.accepts(*best.front())) {
+            ts.errors++;
+            JUtil.error("Reopened SolutionArchive lost its index\n");
+        }
+    }
+
+    // Copies in one list take no more than one candidate slot, so the
+    // archive still fills with the best distinct teams.
+    {
+        TeamSPMaxHeap heap;
+        SolutionArchive archive(heap, capacity);
+        std::vector<NodeTeamSP> copies;
+        for (auto const& team : teams) {
+            copies.push_back(team->clone());
+            copies.push_back(team->clone());
+            copies.push_back(team->clone());
+        }
+        auto const candidates = archive.candidates(copies);
+
+        ts.tests++;
+        std::unordered_set<Crc32> checksums;
+        for (auto const team : candidates) {
+            checksums.insert(team->checksum());
+        }
+        if (checksums.size() != candidates.size()) {
+            ts.errors++;
+            JUtil.error("SolutionArchive gave %zu candidates with only %zu "
+                        "checksums\n", candidates.size(), checksums.size());
+        }
+
+        archive.merge({candidates});
+        check_best(heap, "merge() of copies");
+    }
+
+    return ts;
+}
+
+}  /* elfin */
@@ -7,12 +7,20 @@
 #include "work_area.h"
 #include "proto_tests.h"
 #include "scoring.h"
+#include "collision.h"
 #include "random_utils.h"
+#include "parallel_utils.h"
+#include "mutation.h"
+#include "fitness_cache.h"
+#include "first_rank_table.h"
 #include "input_manager.h"
 #include "path_generator.h"
 #include "path_team.h"
 #include "hinge_team.h"
 #include "double_hinge_team.h"
+#include "seeding.h"
+#include "checkpoint.h"
+#include "solution_archive.h"
 #include "evolution_solver.h"
 
 namespace elfin {
@@ -37,14 +45,22 @@ TestStat test_units() {
     test_fragment(proto::test);
     test_fragment(WorkArea::test);
     test_fragment(random::test);
+    test_fragment(parallel::test);
     test_fragment(Transform::test);
     test_fragment(Vector3f::test);
     test_fragment(scoring::test);
+    test_fragment(collision::test);
+    test_fragment(mutation::test);
+    test_fragment(FitnessCache::test);
+    test_fragment(FirstRankTable::test);
 
     test_fragment(PathTeam::test);
     test_fragment(PathGenerator::test);
     test_fragment(HingeTeam::test);
     test_fragment(DoubleHingeTeam::test);
+    test_fragment(seeding::test);
+    test_fragment(checkpoint::test);
+    test_fragment(SolutionArchive::test);
     return total;
 }
 
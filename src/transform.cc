@@ -60,6 +60,22 @@ Transform::Transform(elfin::Mat3f const& rot, Vector3f const& vec) {
 #endif  /* ifdef USE_EIGEN */
 }
 
+Transform::Transform(Floats const& floats) {
+#ifdef USE_EIGEN
+    (*this) << floats[0], floats[1], floats[2], floats[3],
+    floats[4], floats[5], floats[6], floats[7],
+    floats[8], floats[9], floats[10], floats[11],
+    0.f, 0.f, 0.f, 1.f;
+#else
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            rot_[i][j] = floats[i * 4 + j];
+        }
+        tran_[i] = floats[i * 4 + 3];
+    }
+#endif  /* ifdef USE_EIGEN */
+}
+
 /* accessors */
 Vector3f Transform::collapsed() const {
 #ifdef USE_EIGEN
@@ -194,6 +210,25 @@ JSON Transform::tran_json() const {
     return out;
 }
 
+Transform::Floats Transform::to_floats() const {
+    Floats res;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+#ifdef USE_EIGEN
+            res[i * 4 + j] = (*this)(i, j);
+#else
+            res[i * 4 + j] = rot_[i][j];
+#endif  /* ifdef USE_EIGEN */
+        }
+#ifdef USE_EIGEN
+        res[i * 4 + 3] = (*this)(i, 3);
+#else
+        res[i * 4 + 3] = tran_[i];
+#endif  /* ifdef USE_EIGEN */
+    }
+    return res;
+}
+
 /* printers */
 #ifdef USE_EIGEN
 Eigen::IOFormat const CleanFormt =
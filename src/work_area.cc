@@ -1,13 +1,16 @@
 #include "work_area.h"
 
 #include <tuple>
+#include <unordered_set>
 #include <sstream>
 
 #include "debug_utils.h"
 #include "input_manager.h"
 #include "ui_joint_path_generator.h"
 #include "evolution_solver.h"
+#include "fitness_cache.h"
 #include "priv_impl.h"
+#include "scoring.h"
 
 namespace elfin {
 
@@ -18,6 +21,7 @@ struct WorkArea::PImpl : public PImplBase<WorkArea> {
     /* data */
     EvolutionSolver solver_;
     TeamSPMaxHeap solutions_;
+    FitnessCache fitness_cache_{OPTIONS.fitness_cache_size};
 
     /* accessors */
     TeamPtrMinHeap solutions_to_minheap() {
@@ -61,6 +65,22 @@ struct WorkArea::PImpl : public PImplBase<WorkArea> {
         return res;
     }
 
+    ResampledPathMap parse_resampled_path_map() const {
+        // Most candidates are longer than the path guide, so keep the
+        // upsampled guides around instead of rebuilding them every score.
+        ResampledPathMap res;
+        size_t const max_size = _.target_size + OPTIONS.len_dev;
+
+        for (auto const& [ui_key, path] : _.path_map) {
+            auto& resampled_paths = res[ui_key];
+            for (size_t size = path.size() + 1; size <= max_size; ++size) {
+                resampled_paths.emplace_back(scoring::upsample(path, size));
+            }
+        }
+
+        return res;
+    }
+
     /* modifiers */
     void solve() {
         solver_.run(/*work_area=*/_, solutions_);
@@ -251,6 +271,46 @@ PtTermFinderSet parse_ptterm_profile(WorkArea::NamedJoints const& occupied_joint
     return res;
 }
 
+collision::SphereTree parse_fixed_modules(
+    FixedAreaMap const& fam,
+    WorkArea::NamedJoints const& occupied_joints)
+{
+    // Occupants become nodes of the candidates themselves, so leave them out.
+    std::unordered_set<UIModKey> occupants;
+    for (auto const& [occ_name, joint] : occupied_joints) {
+        occupants.insert(joint->occupant.ui_module);
+    }
+
+    collision::Spheres spheres;
+    for (auto const& [fa_name, fixed_area] : fam) {
+        for (auto const& [mod_name, ui_mod] : fixed_area->modules) {
+            if (occupants.find(ui_mod.get()) == end(occupants) and
+                    ui_mod->prototype) {
+                spheres.push_back(ui_mod->tx.collapsed(),
+                                  ui_mod->prototype->radius);
+            }
+        }
+    }
+
+    return collision::SphereTree(spheres);
+}
+
+WorkArea::CenteredPathMap parse_centered_path_map(
+    WorkArea::PathMap const& paths,
+    WorkArea::ResampledPathMap const& resampled_paths)
+{
+    // Centered alongside the upsampled guides, so that batches scoring
+    // against this area share them instead of centering their own.
+    WorkArea::CenteredPathMap res;
+    for (auto const& [ui_key, path] : paths) {
+        res.emplace(std::piecewise_construct,
+                    std::forward_as_tuple(ui_key),
+                    std::forward_as_tuple(path, resampled_paths.at(ui_key)));
+    }
+
+    return res;
+}
+
 size_t parse_path_len(WorkArea::PathMap const& paths) {
     auto const& [ui_key, path] = *begin(paths);
     return path.size();
@@ -291,7 +351,10 @@ WorkArea::WorkArea(std::string const& _name,
     ptterm_profile(parse_ptterm_profile(occupied_joints)),
     path_map(pimpl_->parse_path_map(/*relies on joints, leaf_joints*/)),
     path_len(parse_path_len(path_map)),
-    target_size(parse_target_size(path_map))
+    target_size(parse_target_size(path_map)),
+    resampled_path_map(pimpl_->parse_resampled_path_map(/*relies on path_map, target_size*/)),
+    centered_path_map(parse_centered_path_map(path_map, resampled_path_map)),
+    fixed_modules(parse_fixed_modules(fam, occupied_joints))
 {
     PANIC_IF(joints.empty(),
              ShouldNotReach("Work Area \"" + name + "\" has no joints. " +
@@ -306,6 +369,29 @@ TeamPtrMinHeap WorkArea:: make_solution_minheap() const {
     return pimpl_->solutions_to_minheap();
 }
 
+mutation::Stats const& WorkArea::mutation_stats() const {
+    return pimpl_->solver_.mutation_stats();
+}
+
+FitnessCache& WorkArea::fitness_cache() const {
+    return pimpl_->fitness_cache_;
+}
+
+V3fList const& WorkArea::ref_path(UIJointKey const ui_key,
+                                  size_t const size) const
+{
+    auto const& path = path_map.at(ui_key);
+    if (size > path.size()) {
+        auto const& resampled_paths = resampled_path_map.at(ui_key);
+        size_t const id = size - path.size() - 1;
+        if (id < resampled_paths.size()) {
+            return resampled_paths[id];
+        }
+    }
+
+    return path;
+}
+
 /* modifiers */
 void WorkArea::solve() {
     pimpl_->solve();
@@ -2,6 +2,7 @@
 
 #include "test_stat.h"
 #include "input_manager.h"
+#include "scoring.h"
 
 namespace elfin {
 
@@ -70,6 +71,38 @@ TestStat WorkArea::test() {
         };
     }
 
+    // Test cached upsampled reference paths.
+    {
+        InputManager::setup_test({
+            "--spec_file",
+            "examples/quarter_snake_free.json"
+        });
+        Spec const spec(OPTIONS);
+
+        TRACE_NOMSG(spec.work_packages().size() != 1);
+        auto const& wp = *begin(spec.work_packages());
+        auto const& wa = wp->work_area_keys().at(0);
+
+        size_t const max_size = wa->target_size + OPTIONS.len_dev;
+        for (auto const& [ui_key, path] : wa->path_map) {
+            for (size_t size = 1; size <= max_size + 1; ++size) {
+                ts.tests++;
+
+                auto const& ref_path = wa->ref_path(ui_key, size);
+                V3fList const expected =
+                    size > path.size() and size <= max_size ?
+                    scoring::upsample(path, size) :
+                    path;
+
+                if (ref_path != expected) {
+                    ts.errors++;
+                    JUtil.error("Cached reference path of size %zu differs "
+                                "from upsample().\n", size);
+                }
+            }
+        }
+    }
+
     return ts;
 }
 